@@ -0,0 +1,268 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include "BatchRunner.h"
+
+BatchRunner::BatchRunner(int threadCount, int sliceFrames)
+{
+    m_iThreadCount = (threadCount > 0) ? threadCount : 1;
+    m_iSliceFrames = (sliceFrames > 0) ? sliceFrames : 1;
+    m_iPendingTasks = 0;
+    m_iQueuedTasks = 0;
+    m_pWorkers = new Worker[m_iThreadCount];
+
+    for (int i = 0; i < m_iThreadCount; i++)
+    {
+        m_pWorkers[i].pRunner = this;
+        m_pWorkers[i].index = i;
+        pthread_mutex_init(&m_pWorkers[i].mutex, NULL);
+    }
+
+    pthread_mutex_init(&m_PendingMutex, NULL);
+    pthread_cond_init(&m_PendingCondition, NULL);
+}
+
+BatchRunner::~BatchRunner()
+{
+    for (int i = 0; i < m_iThreadCount; i++)
+        pthread_mutex_destroy(&m_pWorkers[i].mutex);
+
+    pthread_mutex_destroy(&m_PendingMutex);
+    pthread_cond_destroy(&m_PendingCondition);
+    SafeDeleteArray(m_pWorkers);
+}
+
+void BatchRunner::Run(BatchJob* pJobs, int jobCount)
+{
+    Task* pTasks = new Task[jobCount];
+
+    m_iPendingTasks = jobCount;
+    m_iQueuedTasks = jobCount;
+
+    for (int i = 0; i < jobCount; i++)
+    {
+        pJobs[i].loaded = false;
+        pJobs[i].szName[0] = 0;
+        pJobs[i].cycles = 0;
+        pJobs[i].frameHash = 0;
+
+        pTasks[i].pJob = &pJobs[i];
+        InitPointer(pTasks[i].pCore);
+        InitPointer(pTasks[i].pFrameBuffer);
+        InitPointer(pTasks[i].pAudioSink);
+        pTasks[i].remainingFrames = pJobs[i].frames;
+
+        m_pWorkers[i % m_iThreadCount].tasks.push_back(&pTasks[i]);
+    }
+
+    for (int i = 1; i < m_iThreadCount; i++)
+        pthread_create(&m_pWorkers[i].thread, NULL, WorkerThread, &m_pWorkers[i]);
+
+    WorkerLoop(&m_pWorkers[0]);
+
+    for (int i = 1; i < m_iThreadCount; i++)
+        pthread_join(m_pWorkers[i].thread, NULL);
+
+    SafeDeleteArray(pTasks);
+}
+
+void* BatchRunner::WorkerThread(void* pArg)
+{
+    Worker* pWorker = static_cast<Worker*> (pArg);
+    pWorker->pRunner->WorkerLoop(pWorker);
+    return NULL;
+}
+
+void BatchRunner::WorkerLoop(Worker* pWorker)
+{
+    while (true)
+    {
+        Task* pTask = PopTask(pWorker);
+
+        if (!IsValidPointer(pTask))
+            pTask = StealTask(pWorker);
+
+        if (!IsValidPointer(pTask))
+        {
+            // the remaining tasks are being run by other workers
+            if (!WaitForTasks())
+                break;
+
+            continue;
+        }
+
+        if (RunSlice(pTask))
+            PushTask(pWorker, pTask);
+        else
+            FinishTask(pTask);
+    }
+}
+
+BatchRunner::Task* BatchRunner::PopTask(Worker* pWorker)
+{
+    Task* pTask = NULL;
+
+    pthread_mutex_lock(&pWorker->mutex);
+    if (!pWorker->tasks.empty())
+    {
+        pTask = pWorker->tasks.back();
+        pWorker->tasks.pop_back();
+    }
+    pthread_mutex_unlock(&pWorker->mutex);
+
+    if (IsValidPointer(pTask))
+        TakeQueuedTask();
+
+    return pTask;
+}
+
+BatchRunner::Task* BatchRunner::StealTask(Worker* pWorker)
+{
+    for (int i = 1; i < m_iThreadCount; i++)
+    {
+        Worker* pVictim = &m_pWorkers[(pWorker->index + i) % m_iThreadCount];
+        Task* pTask = NULL;
+
+        pthread_mutex_lock(&pVictim->mutex);
+        if (!pVictim->tasks.empty())
+        {
+            pTask = pVictim->tasks.front();
+            pVictim->tasks.pop_front();
+        }
+        pthread_mutex_unlock(&pVictim->mutex);
+
+        if (IsValidPointer(pTask))
+        {
+            TakeQueuedTask();
+            return pTask;
+        }
+    }
+
+    return NULL;
+}
+
+void BatchRunner::PushTask(Worker* pWorker, Task* pTask)
+{
+    pthread_mutex_lock(&pWorker->mutex);
+    pWorker->tasks.push_back(pTask);
+    pthread_mutex_unlock(&pWorker->mutex);
+
+    pthread_mutex_lock(&m_PendingMutex);
+    m_iQueuedTasks++;
+    pthread_cond_signal(&m_PendingCondition);
+    pthread_mutex_unlock(&m_PendingMutex);
+}
+
+bool BatchRunner::RunSlice(Task* pTask)
+{
+    if (!IsValidPointer(pTask->pCore))
+    {
+        pTask->pCore = new GearboyCore();
+        pTask->pCore->Init();
+
+        if (IsValidPointer(pTask->pJob->szWavPath))
+        {
+            pTask->pAudioSink = new WavAudioSink(pTask->pJob->szWavPath);
+            pTask->pCore->SetAudioSink(pTask->pAudioSink);
+        }
+        else
+            pTask->pCore->EnableSound(false);
+
+        if (!pTask->pCore->LoadROM(pTask->pJob->szRomPath, pTask->pJob->forceDMG))
+            return false;
+
+        pTask->pJob->loaded = true;
+        strncpy(pTask->pJob->szName, pTask->pCore->GetCartridge()->GetName(), 15);
+        pTask->pJob->szName[15] = 0;
+        pTask->pFrameBuffer = new GB_Color[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
+        memset(pTask->pFrameBuffer, 0, GAMEBOY_WIDTH * GAMEBOY_HEIGHT * sizeof(GB_Color));
+    }
+
+    int frames = (pTask->remainingFrames < m_iSliceFrames) ? pTask->remainingFrames : m_iSliceFrames;
+
+    for (int i = 0; i < frames; i++)
+    {
+        // skipped frames keep all the timing but produce no pixels, the
+        // last frame of the job is always rendered for the hash
+        int remaining = pTask->remainingFrames - i - 1;
+        bool render = (remaining % (pTask->pJob->frameSkip + 1)) == 0;
+
+        pTask->pCore->RunToVBlank(render ? pTask->pFrameBuffer : NULL);
+    }
+
+    pTask->remainingFrames -= frames;
+
+    return pTask->remainingFrames > 0;
+}
+
+void BatchRunner::FinishTask(Task* pTask)
+{
+    if (pTask->pJob->loaded)
+    {
+        pTask->pJob->cycles = pTask->pCore->GetTotalClockCycles();
+        pTask->pJob->frameHash = HashFrame(pTask->pFrameBuffer);
+    }
+
+    SafeDeleteArray(pTask->pFrameBuffer);
+    SafeDelete(pTask->pCore);
+    SafeDelete(pTask->pAudioSink);
+
+    pthread_mutex_lock(&m_PendingMutex);
+    m_iPendingTasks--;
+    // wake the sleeping workers so they can leave
+    if (m_iPendingTasks == 0)
+        pthread_cond_broadcast(&m_PendingCondition);
+    pthread_mutex_unlock(&m_PendingMutex);
+}
+
+void BatchRunner::TakeQueuedTask()
+{
+    pthread_mutex_lock(&m_PendingMutex);
+    m_iQueuedTasks--;
+    pthread_mutex_unlock(&m_PendingMutex);
+}
+
+// sleeps while every pending task is being run by another worker,
+// returns false once all the tasks are finished
+bool BatchRunner::WaitForTasks()
+{
+    pthread_mutex_lock(&m_PendingMutex);
+    while ((m_iQueuedTasks <= 0) && (m_iPendingTasks > 0))
+        pthread_cond_wait(&m_PendingCondition, &m_PendingMutex);
+    bool pending = m_iPendingTasks > 0;
+    pthread_mutex_unlock(&m_PendingMutex);
+
+    return pending;
+}
+
+u32 HashFrame(const GB_Color* pFrameBuffer)
+{
+    // FNV-1a
+    const u8* pData = reinterpret_cast<const u8*>(pFrameBuffer);
+    int size = GAMEBOY_WIDTH * GAMEBOY_HEIGHT * sizeof(GB_Color);
+    u32 hash = 2166136261u;
+
+    for (int i = 0; i < size; i++)
+    {
+        hash ^= pData[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
@@ -0,0 +1,92 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef BATCHRUNNER_H
+#define	BATCHRUNNER_H
+
+#include <pthread.h>
+#include <deque>
+#include "gearboy.h"
+
+struct BatchJob
+{
+    const char* szRomPath;
+    bool forceDMG;
+    int frames;
+    int frameSkip;
+    const char* szWavPath;
+    bool loaded;
+    char szName[16];
+    u64 cycles;
+    u32 frameHash;
+};
+
+// Runs every job on its own GearboyCore over a pool of worker threads.
+// Jobs advance in slices of whole frames and idle workers steal pending
+// slices from the other workers' queues, or sleep until one is queued.
+class BatchRunner
+{
+public:
+    BatchRunner(int threadCount, int sliceFrames);
+    ~BatchRunner();
+    void Run(BatchJob* pJobs, int jobCount);
+
+private:
+    struct Task
+    {
+        BatchJob* pJob;
+        GearboyCore* pCore;
+        GB_Color* pFrameBuffer;
+        AudioSink* pAudioSink;
+        int remainingFrames;
+    };
+
+    struct Worker
+    {
+        BatchRunner* pRunner;
+        int index;
+        pthread_t thread;
+        pthread_mutex_t mutex;
+        std::deque<Task*> tasks;
+    };
+
+private:
+    static void* WorkerThread(void* pArg);
+    void WorkerLoop(Worker* pWorker);
+    Task* PopTask(Worker* pWorker);
+    Task* StealTask(Worker* pWorker);
+    void PushTask(Worker* pWorker, Task* pTask);
+    bool RunSlice(Task* pTask);
+    void FinishTask(Task* pTask);
+    void TakeQueuedTask();
+    bool WaitForTasks();
+
+private:
+    int m_iThreadCount;
+    int m_iSliceFrames;
+    Worker* m_pWorkers;
+    pthread_mutex_t m_PendingMutex;
+    pthread_cond_t m_PendingCondition;
+    int m_iPendingTasks;
+    int m_iQueuedTasks;
+};
+
+u32 HashFrame(const GB_Color* pFrameBuffer);
+
+#endif	/* BATCHRUNNER_H */
@@ -0,0 +1,242 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "gearboy.h"
+#include "BatchRunner.h"
+
+const int kDefaultFrames = 3600;
+const int kDefaultSliceFrames = 60;
+const double kGameboyClockRate = 4194304.0;
+
+static double get_time()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static const char* type_name(Cartridge::CartridgeTypes type)
+{
+    switch (type)
+    {
+        case Cartridge::CartridgeNoMBC:
+            return "ROM";
+        case Cartridge::CartridgeMBC1:
+            return "MBC1";
+        case Cartridge::CartridgeMBC2:
+            return "MBC2";
+        case Cartridge::CartridgeMBC3:
+            return "MBC3";
+        case Cartridge::CartridgeMBC5:
+            return "MBC5";
+        case Cartridge::CartridgeMBC1Multi:
+            return "MBC1M";
+        default:
+            return "unsupported";
+    }
+}
+
+static int scan(const char** dirs, int dirCount, const char* index, int threads)
+{
+    ROMScanner scanner;
+
+    if (IsValidPointer(index))
+        scanner.LoadIndex(index);
+
+    double start = get_time();
+    int read = scanner.Scan(dirs, dirCount, threads);
+    double elapsed = get_time() - start;
+
+    for (int i = 0; i < scanner.GetCount(); i++)
+    {
+        const ROMInfo* info = scanner.GetInfo(i);
+        printf("%s\t%s\t%s\t%s\trom:%d ram:%d%s%s%s\n", info->szFilePath, info->szName, type_name(info->type),
+                info->cgb ? "CGB" : "DMG", info->romBankCount, info->ramBankCount,
+                info->battery ? " battery" : "", info->rtc ? " rtc" : "", info->validChecksum ? "" : " bad-checksum");
+    }
+
+    printf("roms: %d\nread: %d\ntime: %.3f s\n", scanner.GetCount(), read, elapsed);
+
+    if (IsValidPointer(index) && !scanner.SaveIndex(index))
+    {
+        printf("unable to write index: %s\n", index);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void usage(const char* name)
+{
+    printf("usage: %s rom_path [rom_path ...] [options]\n", name);
+    printf("options:\n-frames n\n-frameskip n\n-forcedmg\n-hash\n-instances n (per rom)\n-threads n\n-slice n (frames)\n-wav path (single instance)\n");
+    printf("       %s -scan dir [-scan dir ...] [-index path] [-threads n]\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        usage(argv[0]);
+        return -1;
+    }
+
+    int frames = kDefaultFrames;
+    int frameskip = 0;
+    bool forcedmg = false;
+    bool hash = false;
+    int instances = 1;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int slice = kDefaultSliceFrames;
+    const char* wav = NULL;
+    const char* index = NULL;
+    int romCount = 0;
+    int dirCount = 0;
+    const char** roms = new const char*[argc];
+    const char** dirs = new const char*[argc];
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((strcmp("-frames", argv[i]) == 0) && (i + 1 < argc))
+            frames = atoi(argv[++i]);
+        else if ((strcmp("-frameskip", argv[i]) == 0) && (i + 1 < argc))
+            frameskip = atoi(argv[++i]);
+        else if (strcmp("-forcedmg", argv[i]) == 0)
+            forcedmg = true;
+        else if (strcmp("-hash", argv[i]) == 0)
+            hash = true;
+        else if ((strcmp("-instances", argv[i]) == 0) && (i + 1 < argc))
+            instances = atoi(argv[++i]);
+        else if ((strcmp("-threads", argv[i]) == 0) && (i + 1 < argc))
+            threads = atoi(argv[++i]);
+        else if ((strcmp("-slice", argv[i]) == 0) && (i + 1 < argc))
+            slice = atoi(argv[++i]);
+        else if ((strcmp("-wav", argv[i]) == 0) && (i + 1 < argc))
+            wav = argv[++i];
+        else if ((strcmp("-scan", argv[i]) == 0) && (i + 1 < argc))
+            dirs[dirCount++] = argv[++i];
+        else if ((strcmp("-index", argv[i]) == 0) && (i + 1 < argc))
+            index = argv[++i];
+        else if (argv[i][0] != '-')
+            roms[romCount++] = argv[i];
+        else
+        {
+            printf("invalid option: %s\n", argv[i]);
+            usage(argv[0]);
+            SafeDeleteArray(roms);
+            SafeDeleteArray(dirs);
+            return -1;
+        }
+    }
+
+    if ((dirCount > 0) && (threads > 0))
+    {
+        int result = scan(dirs, dirCount, index, threads);
+        SafeDeleteArray(roms);
+        SafeDeleteArray(dirs);
+        return result;
+    }
+
+    SafeDeleteArray(dirs);
+
+    if ((romCount == 0) || (frames <= 0) || (frameskip < 0) || (instances <= 0) || (threads <= 0) || (slice <= 0) || (IsValidPointer(wav) && (romCount * instances > 1)))
+    {
+        printf("invalid arguments\n");
+        usage(argv[0]);
+        SafeDeleteArray(roms);
+        return -1;
+    }
+
+    int jobCount = romCount * instances;
+    BatchJob* jobs = new BatchJob[jobCount];
+
+    for (int i = 0; i < jobCount; i++)
+    {
+        jobs[i].szRomPath = roms[i / instances];
+        jobs[i].forceDMG = forcedmg;
+        jobs[i].frames = frames;
+        jobs[i].frameSkip = frameskip;
+        jobs[i].szWavPath = wav;
+    }
+
+    if (threads > jobCount)
+        threads = jobCount;
+
+    BatchRunner* runner = new BatchRunner(threads, slice);
+
+    double start = get_time();
+
+    runner->Run(jobs, jobCount);
+
+    double elapsed = get_time() - start;
+
+    if (elapsed <= 0.0)
+        elapsed = 0.000001;
+
+    int result = 0;
+    u64 cycles = 0;
+
+    for (int i = 0; i < jobCount; i++)
+    {
+        if (!jobs[i].loaded)
+        {
+            printf("unable to load ROM: %s\n", jobs[i].szRomPath);
+            result = -1;
+            continue;
+        }
+
+        cycles += jobs[i].cycles;
+
+        if (jobCount > 1)
+        {
+            printf("[%d] rom: %s cycles: %llu", i, jobs[i].szName, (unsigned long long)jobs[i].cycles);
+            if (hash)
+                printf(" frame hash: %08x", jobs[i].frameHash);
+            printf("\n");
+        }
+    }
+
+    double fps = ((double)frames * jobCount) / elapsed;
+    double cps = cycles / elapsed;
+
+    if (jobCount == 1)
+        printf("rom: %s\n", jobs[0].szName);
+    else
+        printf("instances: %d\nthreads: %d\n", jobCount, threads);
+
+    printf("frames: %d\n", frames);
+    printf("cycles: %llu\n", (unsigned long long)cycles);
+    printf("time: %.3f s\n", elapsed);
+    printf("frames/sec: %.2f\n", fps);
+    printf("cycles/sec: %.0f (%.2fx real time)\n", cps, cps / kGameboyClockRate);
+
+    if (hash && (jobCount == 1))
+        printf("frame hash: %08x\n", jobs[0].frameHash);
+
+    SafeDelete(runner);
+    SafeDeleteArray(jobs);
+    SafeDeleteArray(roms);
+
+    return result;
+}
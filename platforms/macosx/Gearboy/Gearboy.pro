@@ -30,10 +30,17 @@ SOURCES += \
     ../../../src/audio/Multi_Buffer.cpp \
     ../../../src/audio/Sound_Queue.cpp \
     ../../../src/Audio.cpp \
+    ../../../src/WavAudioSink.cpp \
+    ../../../src/SDLAudioSink.cpp \
     ../../../src/Cartridge.cpp \
+    ../../../src/ROMCache.cpp \
+    ../../../src/ROMScanner.cpp \
     ../../../src/CommonMemoryRule.cpp \
     ../../../src/GearboyCore.cpp \
     ../../../src/Input.cpp \
+    ../../../src/Scheduler.cpp \
+    ../../../src/RewindBuffer.cpp \
+    ../../../src/RamSaveWorker.cpp \
     ../../../src/IORegistersMemoryRule.cpp \
     ../../../src/MBC1MemoryRule.cpp \
     ../../../src/MBC2MemoryRule.cpp \
@@ -50,6 +57,7 @@ SOURCES += \
     ../../../src/miniz/miniz.c \
     ../../qt-shared/About.cpp \
     ../../qt-shared/Emulator.cpp \
+    ../../qt-shared/EmulationThread.cpp \
     ../../qt-shared/GLFrame.cpp \
     ../../qt-shared/InputSettings.cpp \
     ../../qt-shared/main.cpp \
@@ -70,14 +78,23 @@ HEADERS  += \
     ../../../src/audio/Multi_Buffer.h \
     ../../../src/audio/Sound_Queue.h \
     ../../../src/Audio.h \
+    ../../../src/AudioSink.h \
+    ../../../src/WavAudioSink.h \
+    ../../../src/SDLAudioSink.h \
     ../../../src/boot_roms.h \
     ../../../src/Cartridge.h \
+    ../../../src/ROMCache.h \
+    ../../../src/ROMScanner.h \
     ../../../src/CommonMemoryRule.h \
     ../../../src/definitions.h \
     ../../../src/EightBitRegister.h \
     ../../../src/gearboy.h \
     ../../../src/GearboyCore.h \
     ../../../src/Input.h \
+    ../../../src/Scheduler.h \
+    ../../../src/RewindBuffer.h \
+    ../../../src/RamSaveWorker.h \
+    ../../../src/MemoryStreamBuffer.h \
     ../../../src/IORegistersMemoryRule.h \
     ../../../src/MBC1MemoryRule.h \
     ../../../src/MBC2MemoryRule.h \
@@ -96,6 +113,7 @@ HEADERS  += \
     ../../../src/Video.h \
     ../../qt-shared/About.h \
     ../../qt-shared/Emulator.h \
+    ../../qt-shared/EmulationThread.h \
     ../../qt-shared/GLFrame.h \
     ../../qt-shared/InputSettings.h \
     ../../qt-shared/MainWindow.h \
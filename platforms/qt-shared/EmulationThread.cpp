@@ -0,0 +1,94 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include "EmulationThread.h"
+#include "Emulator.h"
+
+EmulationThread::EmulationThread() : QThread()
+{
+    m_Running.fetchAndStoreOrdered(1);
+    m_Paused.fetchAndStoreOrdered(0);
+    InitPointer(m_pEmulator);
+    m_iNextFrameTime = 0;
+}
+
+EmulationThread::~EmulationThread()
+{
+}
+
+void EmulationThread::Stop()
+{
+    m_Running.fetchAndStoreOrdered(0);
+}
+
+void EmulationThread::Pause()
+{
+    m_Paused.fetchAndStoreOrdered(1);
+}
+
+void EmulationThread::Resume()
+{
+    m_Paused.fetchAndStoreOrdered(0);
+}
+
+void EmulationThread::SetEmulator(Emulator* pEmulator)
+{
+    m_pEmulator = pEmulator;
+}
+
+void EmulationThread::run()
+{
+    m_Timer.start();
+    m_iNextFrameTime = m_Timer.nsecsElapsed();
+
+    while (m_Running.fetchAndAddOrdered(0) != 0)
+    {
+        if ((m_Paused.fetchAndAddOrdered(0) != 0) || !m_pEmulator->RunToVBlank())
+        {
+            msleep(10);
+            m_iNextFrameTime = m_Timer.nsecsElapsed();
+            continue;
+        }
+
+        WaitForNextFrame();
+    }
+}
+
+void EmulationThread::WaitForNextFrame()
+{
+    // the audio output never blocks, this is the only pacing and the
+    // audio rate control follows it
+    int speed = m_pEmulator->GetSpeed();
+    qint64 now = m_Timer.nsecsElapsed();
+
+    if (speed == kUncappedSpeed)
+    {
+        m_iNextFrameTime = now;
+        return;
+    }
+
+    qint64 frameTime = kFrameNanoseconds / speed;
+
+    m_iNextFrameTime += frameTime;
+
+    if (m_iNextFrameTime > now)
+        usleep((m_iNextFrameTime - now) / 1000);
+    else if ((now - m_iNextFrameTime) > (frameTime * 4))
+        m_iNextFrameTime = now;
+}
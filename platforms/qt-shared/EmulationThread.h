@@ -0,0 +1,55 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef EMULATIONTHREAD_H
+#define	EMULATIONTHREAD_H
+
+#include <QThread>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include "../../src/gearboy.h"
+
+class Emulator;
+
+// 70224 clock cycles per frame at 4194304 Hz
+const qint64 kFrameNanoseconds = 16742706;
+
+class EmulationThread : public QThread
+{
+public:
+    EmulationThread();
+    virtual ~EmulationThread();
+    void run();
+    void Stop();
+    void Pause();
+    void Resume();
+    void SetEmulator(Emulator* pEmulator);
+
+private:
+    void WaitForNextFrame();
+
+private:
+    QAtomicInt m_Running;
+    QAtomicInt m_Paused;
+    Emulator* m_pEmulator;
+    QElapsedTimer m_Timer;
+    qint64 m_iNextFrameTime;
+};
+
+#endif	/* EMULATIONTHREAD_H */
@@ -22,17 +22,46 @@
 Emulator::Emulator()
 {
     InitPointer(m_pGearboyCore);
+    for (int i = 0; i < kFrameBufferCount; i++)
+        InitPointer(m_pFrameBuffers[i]);
+    m_iBackBuffer = 0;
+    m_iFrontBuffer = 1;
+    m_MiddleBuffer.fetchAndStoreOrdered(2);
+    m_InputHead.fetchAndStoreOrdered(0);
+    m_InputTail.fetchAndStoreOrdered(0);
+    m_CGBRom.fetchAndStoreOrdered(0);
+    m_Speed.fetchAndStoreOrdered(1);
 }
 
 Emulator::~Emulator()
 {
     SafeDelete(m_pGearboyCore);
+    for (int i = 0; i < kFrameBufferCount; i++)
+        SafeDeleteArray(m_pFrameBuffers[i]);
 }
 
 void Emulator::Init()
 {
     m_pGearboyCore = new GearboyCore();
     m_pGearboyCore->Init();
+
+    for (int i = 0; i < kFrameBufferCount; i++)
+    {
+        m_pFrameBuffers[i] = new GB_Color[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
+
+        for (int pixel = 0; pixel < (GAMEBOY_WIDTH * GAMEBOY_HEIGHT); pixel++)
+        {
+            m_pFrameBuffers[i][pixel].red = m_pFrameBuffers[i][pixel].green =
+                    m_pFrameBuffers[i][pixel].blue = 0x00;
+            m_pFrameBuffers[i][pixel].alpha = 0xFF;
+        }
+
+        for (int line = 0; line < kDirtyLineWords; line++)
+            m_DirtyLines[i][line] = 0xFFFFFFFF;
+    }
+
+    for (int line = 0; line < kDirtyLineWords; line++)
+        m_PendingDirtyLines[line] = 0;
 }
 
 void Emulator::LoadRom(const char* szFilePath, bool forceDMG)
@@ -41,28 +70,81 @@ void Emulator::LoadRom(const char* szFilePath, bool forceDMG)
     m_pGearboyCore->SaveRam();
     m_pGearboyCore->LoadROM(szFilePath, forceDMG);
     m_pGearboyCore->LoadRam();
+    UpdateCGBRom();
     m_Mutex.unlock();
 }
 
-void Emulator::RunToVBlank(GB_Color* pFrameBuffer)
+bool Emulator::RunToVBlank()
 {
     m_Mutex.lock();
-    m_pGearboyCore->RunToVBlank(pFrameBuffer);
+
+    ProcessInputEvents();
+
+    bool running = m_pGearboyCore->GetCartridge()->IsLoadedROM() && !m_pGearboyCore->IsPaused();
+    bool publish = false;
+
+    if (running)
+    {
+        m_pGearboyCore->RunToVBlank(m_pFrameBuffers[m_iBackBuffer]);
+
+        const u32* pDirtyLines = m_pGearboyCore->GetDirtyLines();
+
+        for (int i = 0; i < kDirtyLineWords; i++)
+            m_PendingDirtyLines[i] |= pDirtyLines[i];
+
+        // with the screen off, or after a partial frame, some lines of the
+        // back buffer still hold the frame it carried two exchanges ago,
+        // so it is only published once a whole frame was written into it
+        publish = m_pGearboyCore->IsFrameComplete();
+    }
+
+    if (publish)
+    {
+        // if the last frame was never picked up the render thread is
+        // missing its changes too, so everything has to be uploaded
+        bool dropped = m_MiddleBuffer.fetchAndAddOrdered(0) & kNewFrameFlag;
+
+        for (int i = 0; i < kDirtyLineWords; i++)
+        {
+            m_DirtyLines[m_iBackBuffer][i] = dropped ? 0xFFFFFFFF : m_PendingDirtyLines[i];
+            m_PendingDirtyLines[i] = 0;
+        }
+    }
+
     m_Mutex.unlock();
+
+    if (publish)
+        m_iBackBuffer = m_MiddleBuffer.fetchAndStoreOrdered(m_iBackBuffer | kNewFrameFlag) & kFrameIndexMask;
+
+    return running;
+}
+
+GB_Color* Emulator::GetFrame(u32* pDirtyLines)
+{
+    bool newFrame = false;
+
+    // only the emulation thread sets the flag, so once it is seen the
+    // exchange is guaranteed to return a complete frame
+    if (m_MiddleBuffer.fetchAndAddOrdered(0) & kNewFrameFlag)
+    {
+        m_iFrontBuffer = m_MiddleBuffer.fetchAndStoreOrdered(m_iFrontBuffer) & kFrameIndexMask;
+        newFrame = true;
+    }
+
+    for (int i = 0; i < kDirtyLineWords; i++)
+        pDirtyLines[i] = newFrame ? m_DirtyLines[m_iFrontBuffer][i] : 0;
+
+    return m_pFrameBuffers[m_iFrontBuffer];
 }
 
 void Emulator::KeyPressed(Gameboy_Keys key)
 {
-    m_Mutex.lock();
-    m_pGearboyCore->KeyPressed(key);
-    m_Mutex.unlock();
+    PushInputEvent(key, true);
 }
 
 void Emulator::KeyReleased(Gameboy_Keys key)
 {
-    m_Mutex.lock();
-    m_pGearboyCore->KeyReleased(key);
-    m_Mutex.unlock();
+    PushInputEvent(key, false);
 }
 
 void Emulator::Pause()
@@ -93,6 +175,7 @@ void Emulator::Reset(bool forceDMG)
     m_pGearboyCore->SaveRam();
     m_pGearboyCore->ResetROM(forceDMG);
     m_pGearboyCore->LoadRam();
+    UpdateCGBRom();
     m_Mutex.unlock();
 }
 
@@ -119,6 +202,26 @@ void Emulator::SetDMGPalette(GB_Color& color1, GB_Color& color2, GB_Color& color
     m_Mutex.unlock();
 }
 
+void Emulator::SetColorCorrection(Gameboy_Color_Correction correction)
+{
+    m_Mutex.lock();
+    m_pGearboyCore->SetColorCorrection(correction);
+    m_Mutex.unlock();
+}
+
+void Emulator::SetSpeed(int multiplier)
+{
+    m_Mutex.lock();
+    m_pGearboyCore->SetSpeed(multiplier);
+    m_Mutex.unlock();
+    m_Speed.fetchAndStoreOrdered(multiplier);
+}
+
+int Emulator::GetSpeed()
+{
+    return m_Speed.fetchAndAddOrdered(0);
+}
+
 void Emulator::SaveRam()
 {
     m_Mutex.lock();
@@ -128,8 +231,46 @@ void Emulator::SaveRam()
 
 bool Emulator::IsCGBRom()
 {
-    m_Mutex.lock();
-    bool cgb = m_pGearboyCore->GetCartridge()->IsCGB();
-    m_Mutex.unlock();
-    return cgb;
+    return m_CGBRom.fetchAndAddOrdered(0) != 0;
+}
+
+void Emulator::PushInputEvent(Gameboy_Keys key, bool pressed)
+{
+    int tail = m_InputTail.fetchAndAddOrdered(0);
+    int next = (tail + 1) % kInputQueueSize;
+
+    if (next == m_InputHead.fetchAndAddOrdered(0))
+    {
+        Log("Input queue full, event dropped");
+        return;
+    }
+
+    m_InputQueue[tail] = static_cast<u8> (key) | (pressed ? 0x80 : 0x00);
+    m_InputTail.fetchAndStoreOrdered(next);
+}
+
+void Emulator::ProcessInputEvents()
+{
+    int head = m_InputHead.fetchAndAddOrdered(0);
+    int tail = m_InputTail.fetchAndAddOrdered(0);
+
+    while (head != tail)
+    {
+        u8 event = m_InputQueue[head];
+        Gameboy_Keys key = static_cast<Gameboy_Keys> (event & 0x7F);
+
+        if (event & 0x80)
+            m_pGearboyCore->KeyPressed(key);
+        else
+            m_pGearboyCore->KeyReleased(key);
+
+        head = (head + 1) % kInputQueueSize;
+    }
+
+    m_InputHead.fetchAndStoreOrdered(head);
+}
+
+void Emulator::UpdateCGBRom()
+{
+    m_CGBRom.fetchAndStoreOrdered(m_pGearboyCore->GetCartridge()->IsCGB() ? 1 : 0);
 }
@@ -21,15 +21,22 @@
 #define	EMULATOR_H
 
 #include <QMutex>
+#include <QAtomicInt>
 #include "../../../src/gearboy.h"
 
+const int kFrameBufferCount = 3;
+const int kNewFrameFlag = 0x04;
+const int kFrameIndexMask = 0x03;
+const int kInputQueueSize = 256;
+
 class Emulator
 {
 public:
     Emulator();
     ~Emulator();
     void Init();
-    void RunToVBlank(GB_Color* pFrameBuffer);
+    bool RunToVBlank();
+    GB_Color* GetFrame(u32* pDirtyLines);
     void LoadRom(const char* szFilePath, bool forceDMG);
     void KeyPressed(Gameboy_Keys key);
     void KeyReleased(Gameboy_Keys key);
@@ -40,12 +47,37 @@ public:
     void MemoryDump();
     void SetSoundSettings(bool enabled, int rate);
     void SetDMGPalette(GB_Color& color1, GB_Color& color2, GB_Color& color3, GB_Color& color4);
+    void SetColorCorrection(Gameboy_Color_Correction correction);
+    void SetSpeed(int multiplier);
+    int GetSpeed();
     void SaveRam();
     bool IsCGBRom();
 
+private:
+    void PushInputEvent(Gameboy_Keys key, bool pressed);
+    void ProcessInputEvents();
+    void UpdateCGBRom();
+
 private:
     GearboyCore* m_pGearboyCore;
     QMutex m_Mutex;
+    // triple buffering: the emulation thread owns the back buffer, the
+    // render thread owns the front buffer and they swap through the
+    // middle one without blocking each other
+    GB_Color* m_pFrameBuffers[kFrameBufferCount];
+    int m_iBackBuffer;
+    int m_iFrontBuffer;
+    QAtomicInt m_MiddleBuffer;
+    // lines that changed since the frame published before each buffer
+    u32 m_DirtyLines[kFrameBufferCount][kDirtyLineWords];
+    // lines changed by the runs whose frame was not published yet
+    u32 m_PendingDirtyLines[kDirtyLineWords];
+    // single producer (UI thread), single consumer (emulation thread)
+    u8 m_InputQueue[kInputQueueSize];
+    QAtomicInt m_InputHead;
+    QAtomicInt m_InputTail;
+    QAtomicInt m_CGBRom;
+    QAtomicInt m_Speed;
 };
 
 #endif	/* EMULATOR_H */
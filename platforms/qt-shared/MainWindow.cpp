@@ -419,6 +419,20 @@ bool MainWindow::eventFilter(QObject * watched, QEvent * event)
 
 bool MainWindow::event(QEvent *ev)
 {
+    // fast forward while tab is held, handled here before
+    // the focus chain gets to use it for navigation
+    if ((ev->type() == QEvent::KeyPress) || (ev->type() == QEvent::KeyRelease))
+    {
+        QKeyEvent* keyEvent = static_cast<QKeyEvent*>(ev);
+
+        if (keyEvent->key() == Qt::Key_Tab)
+        {
+            if (!keyEvent->isAutoRepeat())
+                m_pEmulator->SetSpeed((ev->type() == QEvent::KeyPress) ? kUncappedSpeed : 1);
+            return true;
+        }
+    }
+
     if (ev->type() == QEvent::LayoutRequest)
     {
         if (!m_bFullscreen)
@@ -27,7 +27,7 @@ RenderThread::RenderThread(GLFrame* pGLFrame) : QThread(), m_pGLFrame(pGLFrame)
 {
     m_bPaused = false;
     m_bDoRendering = true;
-    m_pFrameBuffer = new GB_Color[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
+    InitPointer(m_pFrameBuffer);
     m_iWidth = 0;
     m_iHeight = 0;
     InitPointer(m_pEmulator);
@@ -59,11 +59,13 @@ void RenderThread::Stop()
 void RenderThread::Pause()
 {
     m_bPaused = true;
+    m_EmulationThread.Pause();
 }
 
 void RenderThread::Resume()
 {
     m_bPaused = false;
+    m_EmulationThread.Resume();
 }
 
 bool RenderThread::IsRunningEmulator()
@@ -74,6 +76,7 @@ bool RenderThread::IsRunningEmulator()
 void RenderThread::SetEmulator(Emulator* pEmulator)
 {
     m_pEmulator = pEmulator;
+    m_EmulationThread.SetEmulator(pEmulator);
 }
 
 void RenderThread::run()
@@ -82,13 +85,17 @@ void RenderThread::run()
     
     Init();
 
+    m_EmulationThread.start();
+
     while (m_bDoRendering)
     {
         m_pGLFrame->makeCurrent();
 
         if (!m_bPaused)
         {
-            m_pEmulator->RunToVBlank(m_pFrameBuffer);
+            // the emulation runs on its own thread, just pick up
+            // the latest complete frame
+            m_pFrameBuffer = m_pEmulator->GetFrame(m_DirtyLines);
 
             if (m_bResizeEvent)
             {
@@ -105,7 +112,9 @@ void RenderThread::run()
         m_pGLFrame->swapBuffers();
     }
     
-    SafeDeleteArray(m_pFrameBuffer);
+    m_EmulationThread.Stop();
+    m_EmulationThread.wait();
+
     glDeleteTextures(1, &m_AccumulationTexture);
     glDeleteTextures(1, &m_GBTexture);
     glDeleteFramebuffers(1, &m_AccumulationFramebuffer);
@@ -114,17 +123,7 @@ void RenderThread::run()
 void RenderThread::Init()
 {
     m_bFirstFrame = true;
-
-    for (int y = 0; y < GAMEBOY_HEIGHT; ++y)
-    {
-        for (int x = 0; x < GAMEBOY_WIDTH; ++x)
-        {
-            int pixel = (y * GAMEBOY_WIDTH) + x;
-            m_pFrameBuffer[pixel].red = m_pFrameBuffer[pixel].green =
-                    m_pFrameBuffer[pixel].blue = 0x00;
-            m_pFrameBuffer[pixel].alpha = 0xFF;
-        }
-    }
+    m_pFrameBuffer = m_pEmulator->GetFrame(m_DirtyLines);
 
 #ifndef __APPLE__
     GLenum err = glewInit();
@@ -163,12 +162,34 @@ void RenderThread::SetupTexture(GLvoid* data)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
 }
 
+void RenderThread::UploadDirtyLines()
+{
+    int line = 0;
+
+    // one upload per run of consecutive changed lines
+    while (line < GAMEBOY_HEIGHT)
+    {
+        if ((m_DirtyLines[line >> 5] & (1 << (line & 0x1F))) == 0)
+        {
+            line++;
+            continue;
+        }
+
+        int first = line;
+
+        while ((line < GAMEBOY_HEIGHT) && (m_DirtyLines[line >> 5] & (1 << (line & 0x1F))))
+            line++;
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, GAMEBOY_WIDTH, line - first,
+                GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) (m_pFrameBuffer + (first * GAMEBOY_WIDTH)));
+    }
+}
+
 void RenderThread::RenderFrame()
 {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glBindTexture(GL_TEXTURE_2D, m_GBTexture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GAMEBOY_WIDTH, GAMEBOY_HEIGHT,
-            GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) m_pFrameBuffer);
+    UploadDirtyLines();
     if (m_bFiltering)
     {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -186,8 +207,7 @@ void RenderThread::RenderMixFrames()
 {
     glBindFramebuffer(GL_FRAMEBUFFER, m_AccumulationFramebuffer);
     glBindTexture(GL_TEXTURE_2D, m_GBTexture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GAMEBOY_WIDTH, GAMEBOY_HEIGHT,
-            GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) m_pFrameBuffer);
+    UploadDirtyLines();
 
     float alpha = kMixFrameAlpha;
     if (m_bFirstFrame)
@@ -28,6 +28,7 @@
 #endif
 #include <QThread>
 #include "../../src/gearboy.h"
+#include "EmulationThread.h"
 
 class Emulator;
 class GLFrame;
@@ -56,13 +57,16 @@ protected:
     void RenderMixFrames();
     void RenderQuad(int viewportWidth, int viewportHeight, bool mirrorY);
     void SetupTexture(GLvoid* data);
+    void UploadDirtyLines();
 
 private:
     bool m_bDoRendering, m_bPaused;
     int m_iWidth, m_iHeight;
     GLFrame *m_pGLFrame;
     Emulator* m_pEmulator;
+    EmulationThread m_EmulationThread;
     GB_Color* m_pFrameBuffer;
+    u32 m_DirtyLines[kDirtyLineWords];
     bool m_bFiltering;
     bool m_bMixFrames;
     bool m_bResizeEvent;
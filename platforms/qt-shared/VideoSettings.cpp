@@ -134,6 +134,7 @@ void VideoSettings::PressedOK()
     }
 
     m_pEmulator->SetDMGPalette(gb_color[0], gb_color[1], gb_color[2], gb_color[3]);
+    m_pEmulator->SetColorCorrection(static_cast<Gameboy_Color_Correction> (widget.comboBoxColorCorrection->currentIndex()));
 
     m_pGLFrame->ResumeRenderThread();
     this->accept();
@@ -153,6 +154,7 @@ void VideoSettings::SaveSettings(QSettings& settings)
     settings.setValue("DMGColor4", m_iColors[3]);
     settings.setValue("BilinearFiltering", widget.checkBoxFilter->isChecked());
     settings.setValue("MixFrames", widget.checkBoxMix->isChecked());
+    settings.setValue("ColorCorrection", widget.comboBoxColorCorrection->currentIndex());
 }
 
 void VideoSettings::LoadSettings(QSettings& settings)
@@ -164,6 +166,7 @@ void VideoSettings::LoadSettings(QSettings& settings)
 
     widget.checkBoxFilter->setChecked(settings.value("BilinearFiltering", false).toBool());
     widget.checkBoxMix->setChecked(settings.value("MixFrames", true).toBool());
+    widget.comboBoxColorCorrection->setCurrentIndex(settings.value("ColorCorrection", 0).toInt());
 
     QColor color;
     color.setBlue(m_iColors[0] & 0xFF);
@@ -203,4 +206,5 @@ void VideoSettings::LoadSettings(QSettings& settings)
     }
 
     m_pEmulator->SetDMGPalette(gb_color[0], gb_color[1], gb_color[2], gb_color[3]);
+    m_pEmulator->SetColorCorrection(static_cast<Gameboy_Color_Correction> (widget.comboBoxColorCorrection->currentIndex()));
 }
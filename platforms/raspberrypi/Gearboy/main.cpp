@@ -55,7 +55,7 @@ const GLfloat kQuadTex[8] = { 0, 0, kGB_TexWidth, 0, kGB_TexWidth, kGB_TexHeight
 GLshort quadVerts[8];
 
 GearboyCore* theGearboyCore;
-GB_Color* theFrameBuffer;
+u16* theFrameBuffer;
 GLuint theGBTexture;
 
 struct palette_color
@@ -77,6 +77,11 @@ uint32_t screen_width, screen_height;
 
 SDL_Window* theWindow;
 
+void ram_changed(void)
+{
+    theGearboyCore->SaveRamAsync();
+}
+
 void update(void)
 {
     SDL_Event keyevent;
@@ -200,7 +205,8 @@ void update(void)
 
     theGearboyCore->RunToVBlank(theFrameBuffer);
 
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 160, 144, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) theFrameBuffer);
+    if (theGearboyCore->IsFrameDirty())
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 160, 144, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, (GLvoid*) theFrameBuffer);
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
     eglSwapBuffers(display, surface);
 }
@@ -442,7 +448,7 @@ void init_ogl(void)
 
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, theGBTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*) NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 256, 256, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, (GLvoid*) NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
@@ -480,18 +486,13 @@ void init(void)
 
     theGearboyCore = new GearboyCore();
     theGearboyCore->Init();
+    theGearboyCore->SetPixelFormat(Pixel_Format_RGB565);
+    theGearboyCore->SetRamModificationCallback(ram_changed);
 
-    theFrameBuffer = new GB_Color[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
+    theFrameBuffer = new u16[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
 
-    for (int y = 0; y < GAMEBOY_HEIGHT; ++y)
-    {
-        for (int x = 0; x < GAMEBOY_WIDTH; ++x)
-        {
-            int pixel = (y * GAMEBOY_WIDTH) + x;
-            theFrameBuffer[pixel].red = theFrameBuffer[pixel].green = theFrameBuffer[pixel].blue = 0x00;
-            theFrameBuffer[pixel].alpha = 0xFF;
-        }
-    }
+    for (int pixel = 0; pixel < (GAMEBOY_WIDTH * GAMEBOY_HEIGHT); ++pixel)
+        theFrameBuffer[pixel] = 0;
 }
 
 void end(void)
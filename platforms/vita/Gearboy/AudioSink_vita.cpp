@@ -0,0 +1,92 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include <psp2/audioout.h>
+#include "AudioSink_vita.h"
+
+VitaAudioSink::VitaAudioSink()
+{
+    m_iPort = -1;
+    m_iChannels = 2;
+    m_iBufferPos = 0;
+}
+
+VitaAudioSink::~VitaAudioSink()
+{
+    Stop();
+}
+
+bool VitaAudioSink::Start(int sampleRate, int channels)
+{
+    if (m_iPort >= 0)
+        return true;
+
+    SceAudioOutMode mode = (channels == 2) ? SCE_AUDIO_OUT_MODE_STEREO : SCE_AUDIO_OUT_MODE_MONO;
+
+    m_iPort = sceAudioOutOpenPort(SCE_AUDIO_OUT_PORT_TYPE_BGM, kVitaAudioGrain, sampleRate, mode);
+
+    if (m_iPort < 0)
+    {
+        Log("--> ** (%d) Vita Audio port not opened", m_iPort);
+        m_iPort = -1;
+        return false;
+    }
+
+    m_iChannels = channels;
+    m_iBufferPos = 0;
+
+    return true;
+}
+
+void VitaAudioSink::Stop()
+{
+    if (m_iPort < 0)
+        return;
+
+    sceAudioOutReleasePort(m_iPort);
+    m_iPort = -1;
+}
+
+void VitaAudioSink::Write(const s16* pSamples, int count)
+{
+    int grainSize = kVitaAudioGrain * m_iChannels;
+
+    while (count > 0)
+    {
+        int n = grainSize - m_iBufferPos;
+        if (n > count)
+            n = count;
+
+        memcpy(m_Buffer + m_iBufferPos, pSamples, n * sizeof(s16));
+        pSamples += n;
+        m_iBufferPos += n;
+        count -= n;
+
+        if (m_iBufferPos >= grainSize)
+        {
+            sceAudioOutOutput(m_iPort, m_Buffer);
+            m_iBufferPos = 0;
+        }
+    }
+}
+
+void VitaAudioSink::Flush()
+{
+    m_iBufferPos = 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef AUDIOSINK_VITA_H
+#define	AUDIOSINK_VITA_H
+
+#include "AudioSink.h"
+
+// samples per channel handed to the audio port on each output call
+const int kVitaAudioGrain = 1024;
+
+// blocking output through a BGM audio port, sceAudioOutOutput
+// waits for the previous grain so it paces the emulation
+class VitaAudioSink : public AudioSink
+{
+public:
+    VitaAudioSink();
+    ~VitaAudioSink();
+    bool Start(int sampleRate, int channels);
+    void Stop();
+    void Write(const s16* pSamples, int count);
+    void Flush();
+
+private:
+    int m_iPort;
+    int m_iChannels;
+    int m_iBufferPos;
+    s16 m_Buffer[kVitaAudioGrain * 2];
+};
+
+#endif	/* AUDIOSINK_VITA_H */
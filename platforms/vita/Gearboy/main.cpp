@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include <cstdlib>
 #include "gearboy.h"
+#include "AudioSink_vita.h"
 
 #include <psp2/ctrl.h>
 #include <psp2/kernel/processmgr.h>
@@ -52,6 +53,7 @@ static float fullscreen_scale_y = 0.0f;
 static const char *output_file = "gearboy.cfg";
 
 static GearboyCore *theGearboyCore;
+static VitaAudioSink *theAudioSink;
 static GB_Color *theFrameBuffer;
 static vita2d_texture *gb_texture;
 static void *gb_texture_pixels;
@@ -99,12 +101,17 @@ static void init(void)
 
 	theGearboyCore = new GearboyCore();
 	theGearboyCore->Init();
+	theGearboyCore->SetPixelFormat(Pixel_Format_RGBA8888, vita2d_texture_get_stride(gb_texture));
+
+	theAudioSink = new VitaAudioSink();
+	theGearboyCore->SetAudioSink(theAudioSink);
 }
 
 static void end(void)
 {
 	SafeDeleteArray(theFrameBuffer);
 	SafeDelete(theGearboyCore);
+	SafeDelete(theAudioSink);
 	vita2d_fini();
 	vita2d_free_texture(gb_texture);
 }
@@ -157,7 +164,7 @@ static void update(void)
 
 	update_input();
 
-	theGearboyCore->RunToVBlank((GB_Color *)gb_texture_pixels);
+	theGearboyCore->RunToVBlank(gb_texture_pixels);
 
 	if (fullscreen) {
 		vita2d_draw_texture_scale(gb_texture, 0, 0,
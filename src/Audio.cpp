@@ -19,17 +19,27 @@
 
 #include "Audio.h"
 #include "Memory.h"
+#ifndef GEARBOY_NO_SDL
+#include "SDLAudioSink.h"
+#endif
 
 Audio::Audio()
 {
     m_bCGB = false;
     m_bEnabled = true;
+    m_bSynthesize = false;
     m_Time = 0;
     m_AbsoluteTime = 0;
     m_iSampleRate = 44100;
+    m_iSpeed = 1;
+    m_ClockRate = kAudioClockRate;
+    m_fRateAdjustment = 1.0f;
+    m_fFillRatio = 1.0f;
+    m_bSinkStarted = false;
     InitPointer(m_pApu);
     InitPointer(m_pBuffer);
-    InitPointer(m_pSound);
+    InitPointer(m_pSink);
+    InitPointer(m_pDefaultSink);
     InitPointer(m_pSampleBuffer);
 }
 
@@ -37,36 +47,31 @@ Audio::~Audio()
 {
     SafeDelete(m_pApu);
     SafeDelete(m_pBuffer);
-    SafeDelete(m_pSound);
+    StopSink();
+    SafeDelete(m_pDefaultSink);
     SafeDeleteArray(m_pSampleBuffer);
 }
 
 void Audio::Init()
 {
-    int error = SDL_Init(SDL_INIT_AUDIO);
-    
-    if (error < 0)
-    {
-        Log("--> ** (%d) SDL Audio not initialized: %s", error, SDL_GetError());
-    }
-
-    atexit(SDL_Quit);
-
     m_pSampleBuffer = new blip_sample_t[kSampleBufferSize];
 
     m_pApu = new Gb_Apu();
     m_pBuffer = new Stereo_Buffer();
-    m_pSound = new Sound_Queue();
+#ifndef GEARBOY_NO_SDL
+    m_pDefaultSink = new SDLAudioSink();
+#else
+    m_pDefaultSink = new NullAudioSink();
+#endif
+    m_pSink = m_pDefaultSink;
 
-    m_pBuffer->clock_rate(4194304);
+    m_pBuffer->clock_rate(m_ClockRate);
     m_pBuffer->set_sample_rate(m_iSampleRate);
 
     m_pApu->treble_eq(-15.0);
     m_pBuffer->bass_freq(100);
 
-    m_pApu->set_output(m_pBuffer->center(), m_pBuffer->left(), m_pBuffer->right());
-
-    m_pSound->start(m_iSampleRate, 2);
+    UpdateOutput();
 }
 
 void Audio::Reset(bool bCGB, bool soft)
@@ -87,14 +92,20 @@ void Audio::Reset(bool bCGB, bool soft)
         m_Time = 0;
         m_AbsoluteTime = 0;
     }
-    
-    m_pSound->stop();
-    m_pSound->start(m_iSampleRate, 2);
+
+    if (m_bSinkStarted)
+        m_pSink->Flush();
 }
 
 void Audio::Enable(bool enabled)
 {
     m_bEnabled = enabled;
+
+    if (!m_bEnabled)
+        StopSink();
+
+    if (IsValidPointer(m_pApu))
+        UpdateOutput();
 }
 
 bool Audio::IsEnabled() const
@@ -108,22 +119,166 @@ void Audio::SetSampleRate(int rate)
     {
         m_iSampleRate = rate;
         m_pBuffer->set_sample_rate(m_iSampleRate);
-        m_pSound->stop();
-        m_pSound->start(m_iSampleRate, 2);
+        if (m_bSinkStarted)
+        {
+            StopSink();
+            StartSink();
+        }
+    }
+}
+
+void Audio::SetSpeed(int multiplier)
+{
+    if (multiplier == m_iSpeed)
+        return;
+
+    m_iSpeed = multiplier;
+    UpdateClockRate();
+    UpdateOutput();
+}
+
+int Audio::GetSpeed() const
+{
+    return m_iSpeed;
+}
+
+void Audio::SetSink(AudioSink* pSink)
+{
+    StopSink();
+    m_pSink = IsValidPointer(pSink) ? pSink : m_pDefaultSink;
+    m_fRateAdjustment = 1.0f;
+    m_fFillRatio = 1.0f;
+    UpdateClockRate();
+}
+
+// emulating N times faster produces N times more clocks per second
+// of real time, the band limited resampler decimates them so the
+// sink keeps being fed at its own rate with the pitch raised
+void Audio::UpdateClockRate()
+{
+    if (m_iSpeed == kUncappedSpeed)
+        return;
+
+    long rate = static_cast<long> ((static_cast<double> (kAudioClockRate) * m_iSpeed) / m_fRateAdjustment);
+
+    if (rate != m_ClockRate)
+    {
+        m_ClockRate = rate;
+        m_pBuffer->clock_rate(m_ClockRate);
+    }
+}
+
+// the APU keeps running its registers, length counters and status bits
+// with no outputs attached, only the oscillator synthesis is skipped, so
+// nothing is produced while disabled or uncapped
+void Audio::UpdateOutput()
+{
+    bool synthesize = m_bEnabled && (m_iSpeed != kUncappedSpeed);
+
+    if (synthesize == m_bSynthesize)
+        return;
+
+    m_bSynthesize = synthesize;
+
+    if (m_bSynthesize)
+    {
+        m_pBuffer->clear();
+        m_pApu->set_output(m_pBuffer->center(), m_pBuffer->left(), m_pBuffer->right());
     }
+    else
+        m_pApu->set_output(NULL, NULL, NULL);
 }
 
 void Audio::EndFrame()
 {
     m_pApu->end_frame(m_AbsoluteTime);
+
+    if (!m_bSynthesize)
+        return;
+
     m_pBuffer->end_frame(m_AbsoluteTime);
 
-    if (m_pBuffer->samples_avail() >= kSampleBufferSize)
+    // small writes every sound frame keep the queued latency low
+    long count = m_pBuffer->read_samples(m_pSampleBuffer, kSampleBufferSize);
+
+    if (count == 0)
+        return;
+
+    StartSink();
+
+    if (!m_bSinkStarted)
+        return;
+
+    m_pSink->Write(m_pSampleBuffer, (int)count);
+
+    float fill = m_pSink->GetFillRatio();
+
+    // dynamic rate control, the host paces the emulation and the output
+    // rate is nudged so the sink queue drifts back to its target latency
+    if (fill >= 0.0f)
     {
-        long count = m_pBuffer->read_samples(m_pSampleBuffer, kSampleBufferSize);
-        if (m_bEnabled)
-        {
-            m_pSound->write(m_pSampleBuffer, (int)count);
-        }
+        m_fFillRatio += (fill - m_fFillRatio) * kRateControlSmoothing;
+
+        float error = (1.0f - m_fFillRatio) / kRateControlRange;
+
+        if (error > 1.0f)
+            error = 1.0f;
+        else if (error < -1.0f)
+            error = -1.0f;
+
+        m_fRateAdjustment = 1.0f + (kMaxRateAdjustment * error);
+        UpdateClockRate();
     }
 }
+
+void Audio::StartSink()
+{
+    if (!m_bSinkStarted)
+        m_bSinkStarted = m_pSink->Start(m_iSampleRate, 2);
+}
+
+void Audio::StopSink()
+{
+    if (!m_bSinkStarted)
+        return;
+
+    m_pSink->Stop();
+    m_bSinkStarted = false;
+}
+
+void Audio::SaveState(std::ostream& stream)
+{
+    // a status read brings the APU up to the current cycle without
+    // ending the frame, so saving does not change the audio timing
+    m_pApu->read_register(m_Time, 0xFF26);
+
+    gb_apu_state_t apu_state;
+    m_pApu->save_state(&apu_state);
+
+    // store the APU times relative to the current cycle
+    apu_state.frame_time -= m_Time;
+
+    stream.write(reinterpret_cast<const char*> (&apu_state), sizeof(apu_state));
+    stream.write(reinterpret_cast<const char*> (&m_Time), sizeof(m_Time));
+    stream.write(reinterpret_cast<const char*> (&m_AbsoluteTime), sizeof(m_AbsoluteTime));
+}
+
+void Audio::LoadState(std::istream& stream)
+{
+    gb_apu_state_t apu_state;
+
+    stream.read(reinterpret_cast<char*> (&apu_state), sizeof(apu_state));
+    stream.read(reinterpret_cast<char*> (&m_Time), sizeof(m_Time));
+    stream.read(reinterpret_cast<char*> (&m_AbsoluteTime), sizeof(m_AbsoluteTime));
+
+    m_pApu->reset(m_bCGB ? Gb_Apu::mode_cgb : Gb_Apu::mode_dmg);
+    m_pApu->load_state(apu_state);
+
+    // move the APU time base back so that it is at m_Time again
+    m_pApu->end_frame(-m_Time);
+
+    // nothing is synthesized into the buffer while disabled, and it is
+    // cleared when synthesis starts again
+    if (m_bSynthesize)
+        m_pBuffer->clear();
+}
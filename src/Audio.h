@@ -23,7 +23,7 @@
 #include "definitions.h"
 #include "audio/Multi_Buffer.h"
 #include "audio/Gb_Apu.h"
-#include "audio/Sound_Queue.h"
+#include "AudioSink.h"
 
 class Audio
 {
@@ -35,24 +35,52 @@ public:
     void Enable(bool enabled);
     bool IsEnabled() const;
     void SetSampleRate(int rate);
+    void SetSpeed(int multiplier);
+    int GetSpeed() const;
+    void SetSink(AudioSink* pSink);
     u8 ReadAudioRegister(u16 address);
     void WriteAudioRegister(u16 address, u8 value);
     void EndFrame();
     void Tick(unsigned int clockCycles);
+    void SaveState(std::ostream& stream);
+    void LoadState(std::istream& stream);
+    int GetNextEventCycles() const;
+
+private:
+    void StartSink();
+    void StopSink();
+    void UpdateClockRate();
+    void UpdateOutput();
 
 private:
     bool m_bEnabled;
+    bool m_bSynthesize;
     Gb_Apu* m_pApu;
     Stereo_Buffer* m_pBuffer;
     int m_Time;
     int m_AbsoluteTime;
-    Sound_Queue* m_pSound;
+    AudioSink* m_pSink;
+    AudioSink* m_pDefaultSink;
+    bool m_bSinkStarted;
     int m_iSampleRate;
+    int m_iSpeed;
+    long m_ClockRate;
+    float m_fRateAdjustment;
+    float m_fFillRatio;
     blip_sample_t* m_pSampleBuffer;
     bool m_bCGB;
 };
 
 const int kSampleBufferSize = 2048;
+const long kAudioClockRate = 4194304;
+// dynamic rate control never moves the output rate more than this,
+// the full adjustment is reached a quarter of the target away from it
+const float kMaxRateAdjustment = 0.005f;
+const float kRateControlRange = 0.25f;
+// weight of each new fill reading, smooths out the device periods
+const float kRateControlSmoothing = 0.02f;
+// no frame pacing and no sound output
+const int kUncappedSpeed = 0;
 const long kSoundFrameLength = 10000;
 const u8 kSoundMask[] = {
     0x80, 0x3F, 0x00, 0xFF, 0xBF,                       // NR10-NR14 (0xFF10-0xFF14)
@@ -79,6 +107,11 @@ inline void Audio::Tick(unsigned int clockCycles)
     }
 }
 
+inline int Audio::GetNextEventCycles() const
+{
+    return kSoundFrameLength - m_Time;
+}
+
 inline u8 Audio::ReadAudioRegister(u16 address)
 {
     return m_pApu->read_register(m_Time, address);
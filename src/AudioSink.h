@@ -0,0 +1,50 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef AUDIOSINK_H
+#define	AUDIOSINK_H
+
+#include "definitions.h"
+
+// receives the interleaved stereo samples produced by Audio,
+// the host decides whether Write may block the emulation
+class AudioSink
+{
+public:
+    virtual ~AudioSink() { }
+    virtual bool Start(int sampleRate, int channels) = 0;
+    virtual void Stop() = 0;
+    virtual void Write(const s16* pSamples, int count) = 0;
+    // drops the samples still waiting to be played
+    virtual void Flush() = 0;
+    // queued samples relative to the target latency, 1.0 is on target,
+    // sinks that block the emulation do not need rate control
+    virtual float GetFillRatio() { return -1.0f; }
+};
+
+class NullAudioSink : public AudioSink
+{
+public:
+    bool Start(int, int) { return true; }
+    void Stop() { }
+    void Write(const s16*, int) { }
+    void Flush() { }
+};
+
+#endif	/* AUDIOSINK_H */
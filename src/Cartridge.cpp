@@ -24,6 +24,7 @@
 
 Cartridge::Cartridge()
 {
+    InitPointer(m_pROMImage);
     InitPointer(m_pTheROM);
     m_iTotalSize = 0;
     m_szName[0] = 0;
@@ -47,7 +48,7 @@ Cartridge::Cartridge()
 
 Cartridge::~Cartridge()
 {
-    SafeDeleteArray(m_pTheROM);
+    ROMCache::Release(m_pROMImage);
 }
 
 void Cartridge::Init()
@@ -57,7 +58,9 @@ void Cartridge::Init()
 
 void Cartridge::Reset()
 {
-    SafeDeleteArray(m_pTheROM);
+    ROMCache::Release(m_pROMImage);
+    InitPointer(m_pROMImage);
+    InitPointer(m_pTheROM);
     m_iTotalSize = 0;
     m_szName[0] = 0;
     m_iROMSize = 0;
@@ -138,12 +141,74 @@ bool Cartridge::HasBattery() const
     return m_bBattery;
 }
 
+bool Cartridge::IsROMExtension(const char* path)
+{
+    using namespace std;
+
+    string fn(path);
+    transform(fn.begin(), fn.end(), fn.begin(), (int(*)(int)) tolower);
+    string extension = fn.substr(fn.find_last_of(".") + 1);
+
+    return (extension == "gb") || (extension == "dmg") || (extension == "gbc") || (extension == "cgb") || (extension == "sgb");
+}
+
+bool Cartridge::IsZipExtension(const char* path)
+{
+    using namespace std;
+
+    string fn(path);
+    transform(fn.begin(), fn.end(), fn.begin(), (int(*)(int)) tolower);
+    string extension = fn.substr(fn.find_last_of(".") + 1);
+
+    return (extension == "zip");
+}
+
 u8* Cartridge::GetTheROM() const
 {
     return m_pTheROM;
 }
 
-bool Cartridge::LoadFromZipFile(const u8* buffer, int size)
+static bool FindROMInZip(mz_zip_archive* pZip, mz_zip_archive_file_stat& file_stat)
+{
+    for (unsigned int i = 0; i < mz_zip_reader_get_num_files(pZip); i++)
+    {
+        if (!mz_zip_reader_file_stat(pZip, i, &file_stat))
+        {
+            Log("mz_zip_reader_file_stat() failed!");
+            return false;
+        }
+
+        Log("ZIP Content - Filename: \"%s\", Comment: \"%s\", Uncompressed size: %u, Compressed size: %u", file_stat.m_filename, file_stat.m_comment, (unsigned int) file_stat.m_uncomp_size, (unsigned int) file_stat.m_comp_size);
+
+        if (Cartridge::IsROMExtension(file_stat.m_filename))
+            return true;
+    }
+
+    return false;
+}
+
+struct ZipHeaderReader
+{
+    u8* pHeader;
+    size_t read;
+};
+
+static size_t ReadZipHeader(void* pOpaque, mz_uint64 offset, const void* pBuf, size_t n)
+{
+    ZipHeaderReader* pReader = reinterpret_cast<ZipHeaderReader*> (pOpaque);
+
+    if (offset < kCartridgeHeaderSize)
+    {
+        size_t count = std::min(n, static_cast<size_t> (kCartridgeHeaderSize - offset));
+        memcpy(pReader->pHeader + offset, pBuf, count);
+        pReader->read = static_cast<size_t> (offset) + count;
+    }
+
+    // stop inflating as soon as the header is complete
+    return (pReader->read < kCartridgeHeaderSize) ? n : 0;
+}
+
+bool Cartridge::LoadFromZipFile(const char* path)
 {
     using namespace std;
 
@@ -151,50 +216,42 @@ bool Cartridge::LoadFromZipFile(const u8* buffer, int size)
     mz_bool status;
     memset(&zip_archive, 0, sizeof (zip_archive));
 
-    status = mz_zip_reader_init_mem(&zip_archive, (void*) buffer, size, 0);
+    // only the central directory is read here, entries are inflated from the file
+    status = mz_zip_reader_init_file(&zip_archive, path, 0);
     if (!status)
     {
-        Log("mz_zip_reader_init_mem() failed!");
+        Log("mz_zip_reader_init_file() failed!");
         return false;
     }
 
-    for (unsigned int i = 0; i < mz_zip_reader_get_num_files(&zip_archive); i++)
+    mz_zip_archive_file_stat file_stat;
+
+    if (FindROMInZip(&zip_archive, file_stat))
     {
-        mz_zip_archive_file_stat file_stat;
-        if (!mz_zip_reader_file_stat(&zip_archive, i, &file_stat))
+        if ((file_stat.m_uncomp_size == 0) || (file_stat.m_uncomp_size > kROMImageMaxSize))
         {
-            Log("mz_zip_reader_file_stat() failed!");
+            Log("Invalid ROM size in ZIP: %u", (unsigned int) file_stat.m_uncomp_size);
             mz_zip_reader_end(&zip_archive);
             return false;
         }
 
-        Log("ZIP Content - Filename: \"%s\", Comment: \"%s\", Uncompressed size: %u, Compressed size: %u", file_stat.m_filename, file_stat.m_comment, (unsigned int) file_stat.m_uncomp_size, (unsigned int) file_stat.m_comp_size);
-
-        string fn((const char*) file_stat.m_filename);
-        transform(fn.begin(), fn.end(), fn.begin(), (int(*)(int)) tolower);
-        string extension = fn.substr(fn.find_last_of(".") + 1);
+        int size = static_cast<int> (file_stat.m_uncomp_size);
+        u8* pData = ROMCache::Allocate(size);
 
-        if ((extension == "gb") || (extension == "dmg") || (extension == "gbc") || (extension == "cgb") || (extension == "sgb"))
+        if (!mz_zip_reader_extract_to_mem(&zip_archive, file_stat.m_file_index, pData, size, 0))
         {
-            void *p;
-            size_t uncomp_size;
-
-            p = mz_zip_reader_extract_file_to_heap(&zip_archive, file_stat.m_filename, &uncomp_size, 0);
-            if (!p)
-            {
-                Log("mz_zip_reader_extract_file_to_heap() failed!");
-                mz_zip_reader_end(&zip_archive);
-                return false;
-            }
-
-            bool ok = LoadFromBuffer((const u8*) p, static_cast<int>(uncomp_size));
-
-            free(p);
+            Log("mz_zip_reader_extract_to_mem() failed!");
+            SafeDeleteArray(pData);
             mz_zip_reader_end(&zip_archive);
-
-            return ok;
+            return false;
         }
+
+        mz_zip_reader_end(&zip_archive);
+
+        return AttachROMImage(ROMCache::Insert(pData, size, m_szFilePath));
     }
+
+    mz_zip_reader_end(&zip_archive);
     return false;
 }
 
@@ -206,93 +263,159 @@ bool Cartridge::LoadFromFile(const char* path)
 
     Reset();
 
-    strcpy(m_szFilePath, path);
+    SetFilePath(path);
 
-    std::string pathstr(path);
-    std::string filename;
+    // instances loading the same unchanged file share its image
+    ROMImage* pImage = ROMCache::Find(path);
 
-    size_t pos = pathstr.find_last_of("\\");
-    if (pos != std::string::npos)
+    if (IsValidPointer(pImage))
     {
-        filename.assign(pathstr.begin() + pos + 1, pathstr.end());
+        m_bLoaded = AttachROMImage(pImage);
+    }
+    else if (IsZipExtension(path))
+    {
+        Log("Loading from ZIP...");
+        m_bLoaded = LoadFromZipFile(path);
     }
     else
     {
-        pos = pathstr.find_last_of("/");
-        if (pos != std::string::npos)
-        {
-            filename.assign(pathstr.begin() + pos + 1, pathstr.end());
-        }
-        else
-        {
-            filename = pathstr;
-        }
+        m_bLoaded = AttachROMImage(ROMCache::LoadFile(path));
     }
-    
-    strcpy(m_szFileName, filename.c_str());
 
-    ifstream file(path, ios::in | ios::binary | ios::ate);
+    if (m_bLoaded)
+    {
+        Log("ROM loaded", path);
+    }
+    else
+    {
+        Log("There was a problem loading the memory for file %s...", path);
+    }
 
-    if (file.is_open())
+    if (!m_bLoaded)
     {
-        int size = static_cast<int> (file.tellg());
-        char* memblock = new char[size];
-        file.seekg(0, ios::beg);
-        file.read(memblock, size);
-        file.close();
+        Reset();
+    }
 
-        string fn(path);
-        transform(fn.begin(), fn.end(), fn.begin(), (int(*)(int)) tolower);
-        string extension = fn.substr(fn.find_last_of(".") + 1);
+    return m_bLoaded;
+}
 
-        if (extension == "zip")
-        {
-            Log("Loading from ZIP...");
-            m_bLoaded = LoadFromZipFile(reinterpret_cast<u8*> (memblock), size);
-        }
-        else
-        {
-            m_bLoaded = LoadFromBuffer(reinterpret_cast<u8*> (memblock), size);
-        }
+bool Cartridge::LoadHeaderFromFile(const char* path)
+{
+    using namespace std;
 
-        if (m_bLoaded)
-        {
-            Log("ROM loaded", path);
-        }
-        else
+    Reset();
+
+    SetFilePath(path);
+
+    u8 header[kCartridgeHeaderSize];
+    bool read = false;
+
+    if (IsZipExtension(path))
+    {
+        mz_zip_archive zip_archive;
+        memset(&zip_archive, 0, sizeof (zip_archive));
+
+        if (mz_zip_reader_init_file(&zip_archive, path, 0))
         {
-            Log("There was a problem loading the memory for file %s...", path);
-        }
+            mz_zip_archive_file_stat file_stat;
+
+            if (FindROMInZip(&zip_archive, file_stat) && (file_stat.m_uncomp_size >= kCartridgeHeaderSize) && (file_stat.m_uncomp_size <= kROMImageMaxSize))
+            {
+                ZipHeaderReader reader;
+                reader.pHeader = header;
+                reader.read = 0;
+
+                mz_zip_reader_extract_to_callback(&zip_archive, file_stat.m_file_index, ReadZipHeader, &reader, 0);
+
+                m_iTotalSize = static_cast<int> (file_stat.m_uncomp_size);
+                read = (reader.read == kCartridgeHeaderSize);
+            }
 
-        SafeDeleteArray(memblock);
+            mz_zip_reader_end(&zip_archive);
+        }
     }
     else
     {
-        Log("There was a problem loading the file %s...", path);
-        m_bLoaded = false;
+        ifstream file(path, ios::in | ios::binary | ios::ate);
+
+        if (file.is_open())
+        {
+            long long size = static_cast<long long> (file.tellg());
+
+            if ((size >= kCartridgeHeaderSize) && (size <= kROMImageMaxSize))
+            {
+                file.seekg(0, ios::beg);
+                file.read(reinterpret_cast<char*> (header), kCartridgeHeaderSize);
+
+                m_iTotalSize = static_cast<int> (size);
+                read = (file.gcount() == kCartridgeHeaderSize);
+            }
+        }
     }
 
-    if (!m_bLoaded)
+    if (!read)
     {
+        Log("There was a problem reading the header of %s...", path);
         Reset();
+        return false;
     }
 
-    return m_bLoaded;
+    GatherMetadata(header);
+
+    return true;
 }
 
 bool Cartridge::LoadFromBuffer(const u8* buffer, int size)
 {
     if (IsValidPointer(buffer))
     {
-        m_iTotalSize = size;
-        m_pTheROM = new u8[m_iTotalSize];
-        memcpy(m_pTheROM, buffer, m_iTotalSize);
-        return GatherMetadata();
+        u8* pData = ROMCache::Allocate(size);
+        memcpy(pData, buffer, size);
+        return AttachROMImage(ROMCache::Insert(pData, size, NULL));
     }
     else
         return false;
 }
 
+bool Cartridge::AttachROMImage(ROMImage* pImage)
+{
+    if (!IsValidPointer(pImage))
+        return false;
+
+    m_pROMImage = pImage;
+    m_pTheROM = pImage->pData;
+    m_iTotalSize = pImage->size;
+    return GatherMetadata(m_pTheROM);
+}
+
+void Cartridge::SetFilePath(const char* path)
+{
+    strcpy(m_szFilePath, path);
+
+    std::string pathstr(path);
+    std::string filename;
+
+    size_t pos = pathstr.find_last_of("\\");
+    if (pos != std::string::npos)
+    {
+        filename.assign(pathstr.begin() + pos + 1, pathstr.end());
+    }
+    else
+    {
+        pos = pathstr.find_last_of("/");
+        if (pos != std::string::npos)
+        {
+            filename.assign(pathstr.begin() + pos + 1, pathstr.end());
+        }
+        else
+        {
+            filename = pathstr;
+        }
+    }
+
+    strcpy(m_szFileName, filename.c_str());
+}
+
 void Cartridge::CheckCartridgeType(int type)
 {
     if ((type != 0xEA) && (GetROMSize() == 0))
@@ -504,14 +627,14 @@ unsigned int Cartridge::Pow2Ceil(unsigned int n)
     return n;
 }
 
-bool Cartridge::GatherMetadata()
+bool Cartridge::GatherMetadata(const u8* pHeader)
 {
     char name[12] = {0};
     name[11] = 0;
 
     for (int i = 0; i < 11; i++)
     {
-        name[i] = m_pTheROM[0x0134 + i];
+        name[i] = pHeader[0x0134 + i];
 
         if (name[i] == 0)
         {
@@ -521,12 +644,12 @@ bool Cartridge::GatherMetadata()
 
     strcpy(m_szName, name);
 
-    m_bCGB = (m_pTheROM[0x143] == 0x80) || (m_pTheROM[0x143] == 0xC0);
-    m_bSGB = (m_pTheROM[0x146] == 0x03);
-    int type = m_pTheROM[0x147];
-    m_iROMSize = m_pTheROM[0x148];
-    m_iRAMSize = m_pTheROM[0x149];
-    m_iVersion = m_pTheROM[0x14C];
+    m_bCGB = (pHeader[0x143] == 0x80) || (pHeader[0x143] == 0xC0);
+    m_bSGB = (pHeader[0x146] == 0x03);
+    int type = pHeader[0x147];
+    m_iROMSize = pHeader[0x148];
+    m_iRAMSize = pHeader[0x149];
+    m_iVersion = pHeader[0x14C];
 
     CheckCartridgeType(type);
 
@@ -598,7 +721,7 @@ bool Cartridge::GatherMetadata()
         Log("Battery powered RAM found");
     }
 
-    if (m_pTheROM[0x143] == 0xC0)
+    if (pHeader[0x143] == 0xC0)
     {
         Log("Game Boy Color only");
     }
@@ -616,7 +739,7 @@ bool Cartridge::GatherMetadata()
 
     for (int j = 0x134; j < 0x14E; j++)
     {
-        checksum += m_pTheROM[j];
+        checksum += pHeader[j];
     }
 
     m_bValidROM = ((checksum + 25) & 0xFF) == 0;
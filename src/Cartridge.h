@@ -21,6 +21,7 @@
 #define	CARTRIDGE_H
 
 #include "definitions.h"
+#include "ROMCache.h"
 
 class Cartridge
 {
@@ -56,6 +57,7 @@ public:
     u8* GetTheROM() const;
     bool LoadFromFile(const char* path);
     bool LoadFromBuffer(const u8* buffer, int size);
+    bool LoadHeaderFromFile(const char* path);
     int GetVersion() const;
     bool IsSGB() const;
     bool IsCGB() const;
@@ -63,14 +65,19 @@ public:
     time_t GetCurrentRTC();
     bool IsRTCPresent() const;
     bool IsRumblePresent() const;
+    static bool IsROMExtension(const char* path);
+    static bool IsZipExtension(const char* path);
 
 private:
     unsigned int Pow2Ceil(unsigned int n);
-    bool GatherMetadata();
-    bool LoadFromZipFile(const u8* buffer, int size);
+    bool GatherMetadata(const u8* pHeader);
+    void SetFilePath(const char* path);
+    bool LoadFromZipFile(const char* path);
+    bool AttachROMImage(ROMImage* pImage);
     void CheckCartridgeType(int type);
 
 private:
+    ROMImage* m_pROMImage;
     u8* m_pTheROM;
     int m_iTotalSize;
     char m_szName[16];
@@ -92,4 +99,6 @@ private:
     int m_iROMBankCount;
 };
 
+const int kCartridgeHeaderSize = 0x150;
+
 #endif	/* CARTRIDGE_H */
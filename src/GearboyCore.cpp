@@ -17,6 +17,7 @@
  * 
  */
 
+#include <sstream>
 #include "GearboyCore.h"
 #include "Memory.h"
 #include "Processor.h"
@@ -24,6 +25,10 @@
 #include "Audio.h"
 #include "Input.h"
 #include "Cartridge.h"
+#include "Scheduler.h"
+#include "MemoryStreamBuffer.h"
+#include "RewindBuffer.h"
+#include "RamSaveWorker.h"
 #include "MemoryRule.h"
 #include "CommonMemoryRule.h"
 #include "IORegistersMemoryRule.h"
@@ -34,6 +39,25 @@
 #include "MBC5MemoryRule.h"
 #include "MultiMBC1MemoryRule.h"
 
+enum SaveStateBlocks
+{
+    CoreStateBlock,
+    ProcessorStateBlock,
+    MemoryStateBlock,
+    VideoStateBlock,
+    AudioStateBlock,
+    InputStateBlock,
+    MemoryRuleStateBlock,
+    StateBlockCount
+};
+
+const char kSaveStateBlockIDs[StateBlockCount][4] = {
+    {'C', 'O', 'R', 'E'}, {'C', 'P', 'U', ' '}, {'M', 'E', 'M', ' '}, {'V', 'I', 'D', ' '},
+    {'A', 'P', 'U', ' '}, {'I', 'N', 'P', ' '}, {'M', 'B', 'C', ' '}
+};
+const u32 kSaveStateBlockVersions[StateBlockCount] = {1, 1, 1, 1, 1, 1, 1};
+const char kSaveStateEndID[4] = {'E', 'N', 'D', ' '};
+
 GearboyCore::GearboyCore()
 {
     InitPointer(m_pMemory);
@@ -42,6 +66,9 @@ GearboyCore::GearboyCore()
     InitPointer(m_pAudio);
     InitPointer(m_pInput);
     InitPointer(m_pCartridge);
+    InitPointer(m_pScheduler);
+    InitPointer(m_pRewindBuffer);
+    InitPointer(m_pRamSaveWorker);
     InitPointer(m_pCommonMemoryRule);
     InitPointer(m_pIORegistersMemoryRule);
     InitPointer(m_pRomOnlyMemoryRule);
@@ -57,7 +84,9 @@ GearboyCore::GearboyCore()
     m_bDuringBootROM = false;
     m_bLoadRamPending = false;
     m_szLoadRamPendingPath[0] = 0;
+    m_szRamSavePath[0] = 0;
     InitPointer(m_pRamChangedCallback);
+    m_iTotalClockCycles = 0;
 }
 
 GearboyCore::~GearboyCore()
@@ -80,6 +109,7 @@ GearboyCore::~GearboyCore()
     }
 #endif
 
+    SafeDelete(m_pRamSaveWorker);
     SafeDelete(m_pMBC5MemoryRule);
     SafeDelete(m_pMBC3MemoryRule);
     SafeDelete(m_pMBC2MemoryRule);
@@ -88,6 +118,8 @@ GearboyCore::~GearboyCore()
     SafeDelete(m_pRomOnlyMemoryRule);
     SafeDelete(m_pIORegistersMemoryRule);
     SafeDelete(m_pCommonMemoryRule);
+    SafeDelete(m_pRewindBuffer);
+    SafeDelete(m_pScheduler);
     SafeDelete(m_pCartridge);
     SafeDelete(m_pInput);
     SafeDelete(m_pAudio);
@@ -104,6 +136,9 @@ void GearboyCore::Init()
     m_pAudio = new Audio();
     m_pInput = new Input(m_pMemory, m_pProcessor);
     m_pCartridge = new Cartridge();
+    m_pScheduler = new Scheduler(m_pProcessor, m_pVideo, m_pAudio, m_pInput);
+    m_pRewindBuffer = new RewindBuffer(this);
+    m_pRamSaveWorker = new RamSaveWorker();
 
     m_pMemory->Init();
     m_pProcessor->Init();
@@ -116,17 +151,18 @@ void GearboyCore::Init()
     InitDMGPalette();
 }
 
-void GearboyCore::RunToVBlank(GB_Color* pFrameBuffer)
+void GearboyCore::RunToVBlank(void* pFrameBuffer)
 {
+    m_pVideo->ClearDirtyLines();
+
     if (!m_bPaused && m_pCartridge->IsLoadedROM())
     {
         bool vblank = false;
         while (!vblank)
         {
             unsigned int clockCycles = m_pProcessor->Tick();
-            vblank = m_pVideo->Tick(clockCycles, pFrameBuffer);
-            m_pAudio->Tick(clockCycles);
-            m_pInput->Tick(clockCycles);
+            vblank = m_pScheduler->Tick(clockCycles, static_cast<u8*> (pFrameBuffer));
+            m_iTotalClockCycles += clockCycles;
 
             if (m_bDuringBootROM && m_pProcessor->BootROMfinished())
             {
@@ -150,11 +186,25 @@ void GearboyCore::RunToVBlank(GB_Color* pFrameBuffer)
             m_pCartridge->UpdateCurrentRTC();
         }
 
-        if (!m_bCGB && IsValidPointer(pFrameBuffer))
-            RenderDMGFrame(pFrameBuffer);
+        m_pRewindBuffer->Frame();
     }
 }
 
+const u32* GearboyCore::GetDirtyLines() const
+{
+    return m_pVideo->GetDirtyLines();
+}
+
+bool GearboyCore::IsFrameDirty() const
+{
+    return m_pVideo->IsFrameDirty();
+}
+
+bool GearboyCore::IsFrameComplete() const
+{
+    return m_pVideo->IsFrameComplete();
+}
+
 bool GearboyCore::LoadROM(const char* szFilePath, bool forceDMG)
 {
 #ifdef DEBUG_GEARBOY
@@ -180,6 +230,8 @@ bool GearboyCore::LoadROM(const char* szFilePath, bool forceDMG)
     {
         m_bDuringBootROM = true;
         m_bForceDMG = forceDMG;
+        m_iTotalClockCycles = 0;
+        m_pRewindBuffer->Reset();
         Reset(m_bForceDMG ? false : m_pCartridge->IsCGB());
         m_pMemory->LoadBank0and1FromROM(m_pCartridge->GetTheROM());
         bool romTypeOK = AddMemoryRules();
@@ -231,12 +283,37 @@ void GearboyCore::ResetROM(bool forceDMG)
     {
         m_bDuringBootROM = true;
         m_bForceDMG = forceDMG;
+        m_iTotalClockCycles = 0;
+        m_pRewindBuffer->Reset();
         Reset(m_bForceDMG ? false : m_pCartridge->IsCGB());
         m_pMemory->LoadBank0and1FromROM(m_pCartridge->GetTheROM());
         AddMemoryRules();
     }
 }
 
+void GearboyCore::EnableRewind(bool enabled)
+{
+    m_pRewindBuffer->Enable(enabled);
+}
+
+void GearboyCore::SetRewindParameters(int bufferSize, int maxSnapshots, int frameInterval, int keyframeInterval)
+{
+    m_pRewindBuffer->SetParameters(bufferSize, maxSnapshots, frameInterval, keyframeInterval);
+}
+
+bool GearboyCore::Rewind(int snapshots)
+{
+    if (!m_pCartridge->IsLoadedROM())
+        return false;
+
+    return m_pRewindBuffer->StepBack(snapshots);
+}
+
+int GearboyCore::GetRewindSnapshotCount()
+{
+    return m_pRewindBuffer->GetSnapshotCount();
+}
+
 void GearboyCore::EnableSound(bool enabled)
 {
     m_pAudio->Enable(enabled);
@@ -252,55 +329,61 @@ void GearboyCore::SetSoundSampleRate(int rate)
     m_pAudio->SetSampleRate(rate);
 }
 
-void GearboyCore::SetDMGPalette(GB_Color& color1, GB_Color& color2, GB_Color& color3,
-        GB_Color& color4)
+void GearboyCore::SetSpeed(int multiplier)
 {
-    m_DMGPalette[0] = color1;
-    m_DMGPalette[1] = color2;
-    m_DMGPalette[2] = color3;
-    m_DMGPalette[3] = color4;
-    m_DMGPalette[0].alpha = 0xFF;
-    m_DMGPalette[1].alpha = 0xFF;
-    m_DMGPalette[2].alpha = 0xFF;
-    m_DMGPalette[3].alpha = 0xFF;
+    m_pAudio->SetSpeed(multiplier);
 }
 
-void GearboyCore::SaveRam()
+// the sink is not owned by the core, NULL restores the default one
+void GearboyCore::SetAudioSink(AudioSink* pSink)
 {
-    SaveRam(NULL);
+    m_pAudio->SetSink(pSink);
 }
 
-void GearboyCore::SaveRam(const char* szPath)
+void GearboyCore::SetDMGPalette(GB_Color& color1, GB_Color& color2, GB_Color& color3,
+        GB_Color& color4)
 {
-    if (m_pCartridge->IsLoadedROM() && m_pCartridge->HasBattery() && IsValidPointer(m_pMemory->GetCurrentRule()))
-    {
-        Log("Saving RAM...");
-
-        using namespace std;
-
-        char path[512];
+    GB_Color palette[4];
+    palette[0] = color1;
+    palette[1] = color2;
+    palette[2] = color3;
+    palette[3] = color4;
+    palette[0].alpha = 0xFF;
+    palette[1].alpha = 0xFF;
+    palette[2].alpha = 0xFF;
+    palette[3].alpha = 0xFF;
+
+    m_pVideo->SetDMGPalette(palette);
+}
 
-        if (IsValidPointer(szPath))
-        {
-            strcpy(path, szPath);
-            strcat(path, "/");
-            strcat(path, m_pCartridge->GetFileName());
-        }
-        else
-        {
-            strcpy(path, m_pCartridge->GetFilePath());
-        }
+void GearboyCore::SetColorCorrection(Gameboy_Color_Correction correction)
+{
+    m_pVideo->SetColorCorrection(correction);
+}
 
-        strcat(path, ".gearboy");
+void GearboyCore::SetPixelFormat(Gameboy_Pixel_Format format, int pitch)
+{
+    m_pVideo->SetPixelFormat(format, pitch);
+}
 
-        Log("Save file: %s", path);
+bool GearboyCore::SaveRam()
+{
+    return SaveRam(NULL);
+}
 
-        ofstream file(path, ios::out | ios::binary);
+bool GearboyCore::SaveRam(const char* szPath)
+{
+    return SubmitRam(szPath, true);
+}
 
-        m_pMemory->GetCurrentRule()->SaveRam(file);
+void GearboyCore::SaveRamAsync()
+{
+    SaveRamAsync(NULL);
+}
 
-        Log("RAM saved");
-    }
+void GearboyCore::SaveRamAsync(const char* szPath)
+{
+    SubmitRam(szPath, false);
 }
 
 void GearboyCore::LoadRam()
@@ -328,18 +411,12 @@ void GearboyCore::LoadRam(const char* szPath)
 
         char path[512];
 
-        if (IsValidPointer(szPath))
-        {
-            strcpy(path, szPath);
-            strcat(path, "/");
-            strcat(path, m_pCartridge->GetFileName());
-        }
-        else
-        {
-            strcpy(path, m_pCartridge->GetFilePath());
-        }
+        GetRamPath(szPath, path);
 
-        strcat(path, ".gearboy");
+        // a save still in flight must land before it is read back, and one
+        // interrupted by a power loss is completed from its journal
+        m_pRamSaveWorker->Flush();
+        RamSaveWorker::Recover(path);
 
         Log("Opening save file: %s", path);
 
@@ -389,6 +466,9 @@ void GearboyCore::LoadRam(const char* szPath)
 
                 if (m_pMemory->GetCurrentRule()->LoadRam(file, fileSize))
                 {
+                    // the file now matches the RAM, later saves only patch it
+                    m_pMemory->GetCurrentRule()->ClearRamDirty();
+                    strcpy(m_szRamSavePath, path);
                     Log("RAM loaded");
                 }
                 else
@@ -409,32 +489,357 @@ void GearboyCore::SetRamModificationCallback(RamChangedCallback callback)
     m_pRamChangedCallback = callback;
 }
 
+u64 GearboyCore::GetTotalClockCycles() const
+{
+    return m_iTotalClockCycles;
+}
+
+bool GearboyCore::SaveState(int index)
+{
+    return SaveState(NULL, index);
+}
+
+bool GearboyCore::SaveState(const char* szPath, int index)
+{
+    Log("Saving state...");
+
+    using namespace std;
+
+    char path[512];
+    GetSaveStatePath(szPath, index, path);
+
+    Log("State file: %s", path);
+
+    ofstream file(path, ios::out | ios::binary);
+
+    if (file.fail())
+    {
+        Log("Unable to create state file");
+        return false;
+    }
+
+    bool saved = SaveState(file);
+
+    if (saved)
+    {
+        Log("State saved");
+    }
+
+    return saved;
+}
+
+bool GearboyCore::SaveState(std::ostream& stream)
+{
+    if (!m_pCartridge->IsLoadedROM() || m_bDuringBootROM || !IsValidPointer(m_pMemory->GetCurrentRule()))
+    {
+        Log("Save state not available");
+        return false;
+    }
+
+    // bring all the components up to the current cycle
+    m_pScheduler->Synchronize();
+
+    char signature[16];
+    char romName[16];
+    u32 version = SAVESTATE_VERSION;
+    u8 cgb = m_bCGB ? 1 : 0;
+
+    memset(signature, 0, 16);
+    memset(romName, 0, 16);
+    memcpy(signature, SAVESTATE_SIGNATURE, 16);
+    strncpy(romName, m_pCartridge->GetName(), 15);
+
+    stream.write(signature, 16);
+    stream.write(reinterpret_cast<const char*> (&version), sizeof(version));
+    stream.write(romName, 16);
+    stream.write(reinterpret_cast<const char*> (&cgb), sizeof(cgb));
+
+    for (int block = 0; block < StateBlockCount; block++)
+    {
+        u32 size = 0;
+
+        stream.write(kSaveStateBlockIDs[block], 4);
+        stream.write(reinterpret_cast<const char*> (&kSaveStateBlockVersions[block]), 4);
+        stream.write(reinterpret_cast<const char*> (&size), 4);
+
+        std::streampos start = stream.tellp();
+
+        SaveStateBlock(stream, block);
+
+        std::streampos end = stream.tellp();
+        size = static_cast<u32> (end - start);
+
+        stream.seekp(start - std::streamoff(4));
+        stream.write(reinterpret_cast<const char*> (&size), 4);
+        stream.seekp(end);
+    }
+
+    u32 end_version = 0;
+    u32 end_size = 0;
+
+    stream.write(kSaveStateEndID, 4);
+    stream.write(reinterpret_cast<const char*> (&end_version), 4);
+    stream.write(reinterpret_cast<const char*> (&end_size), 4);
+
+    if (stream.fail())
+    {
+        Log("Error writing state");
+        return false;
+    }
+
+    return true;
+}
+
+bool GearboyCore::LoadState(int index)
+{
+    return LoadState(NULL, index);
+}
+
+bool GearboyCore::LoadState(const char* szPath, int index)
+{
+    Log("Loading state...");
+
+    using namespace std;
+
+    char path[512];
+    GetSaveStatePath(szPath, index, path);
+
+    Log("Opening state file: %s", path);
+
+    ifstream file(path, ios::in | ios::binary);
+
+    if (file.fail())
+    {
+        Log("State file doesn't exist");
+        return false;
+    }
+
+    bool loaded = LoadState(file);
+
+    if (loaded)
+    {
+        Log("State loaded");
+    }
+
+    return loaded;
+}
+
+bool GearboyCore::LoadState(std::istream& stream)
+{
+    if (!m_pCartridge->IsLoadedROM() || !IsValidPointer(m_pMemory->GetCurrentRule()))
+    {
+        Log("Load state not available");
+        return false;
+    }
+
+    char signature[16];
+    char romName[16];
+    u32 version = 0;
+    u8 cgb = 0;
+
+    stream.read(signature, 16);
+    stream.read(reinterpret_cast<char*> (&version), sizeof(version));
+    stream.read(romName, 16);
+    stream.read(reinterpret_cast<char*> (&cgb), sizeof(cgb));
+
+    if (stream.fail() || (strncmp(signature, SAVESTATE_SIGNATURE, 16) != 0))
+    {
+        Log("Invalid state file");
+        return false;
+    }
+
+    if (version > SAVESTATE_VERSION)
+    {
+        Log("Unsupported state version: %d", version);
+        return false;
+    }
+
+    if (strncmp(romName, m_pCartridge->GetName(), 16) != 0)
+    {
+        Log("State belongs to another ROM: %.16s", romName);
+        return false;
+    }
+
+    std::streampos blocks = stream.tellg();
+    stream.seekg(0, stream.end);
+    std::streampos stream_end = stream.tellg();
+    stream.seekg(blocks);
+
+    // validate all the blocks before touching the current state
+    bool found[StateBlockCount];
+
+    for (int block = 0; block < StateBlockCount; block++)
+        found[block] = false;
+
+    while (true)
+    {
+        char id[4];
+        u32 block_version = 0;
+        u32 size = 0;
+
+        stream.read(id, 4);
+        stream.read(reinterpret_cast<char*> (&block_version), 4);
+        stream.read(reinterpret_cast<char*> (&size), 4);
+
+        if (stream.fail())
+        {
+            Log("State file truncated");
+            return false;
+        }
+
+        if (memcmp(id, kSaveStateEndID, 4) == 0)
+            break;
+
+        std::streampos start = stream.tellg();
+
+        if ((stream_end - start) < static_cast<std::streamoff> (size))
+        {
+            Log("State block %.4s truncated", id);
+            return false;
+        }
+
+        int block = FindSaveStateBlock(id);
+
+        if (block >= 0)
+        {
+            if (block_version > kSaveStateBlockVersions[block])
+            {
+                Log("Unsupported state block %.4s version: %d", id, block_version);
+                return false;
+            }
+
+            if (size != GetStateBlockSize(block))
+            {
+                Log("State block %.4s has an invalid size: %d", id, size);
+                return false;
+            }
+
+            found[block] = true;
+        }
+
+        stream.seekg(start + std::streamoff(size));
+    }
+
+    for (int block = 0; block < StateBlockCount; block++)
+    {
+        if (!found[block])
+        {
+            Log("State block %.4s missing", kSaveStateBlockIDs[block]);
+            return false;
+        }
+    }
+
+    if (m_bDuringBootROM || (m_bCGB != (cgb != 0)))
+    {
+        m_bDuringBootROM = false;
+        m_bLoadRamPending = false;
+        Reset(cgb != 0);
+        m_pMemory->LoadBank0and1FromROM(m_pCartridge->GetTheROM());
+        AddMemoryRules();
+    }
+
+    stream.clear();
+    stream.seekg(blocks);
+
+    while (true)
+    {
+        char id[4];
+        u32 block_version = 0;
+        u32 size = 0;
+
+        stream.read(id, 4);
+        stream.read(reinterpret_cast<char*> (&block_version), 4);
+        stream.read(reinterpret_cast<char*> (&size), 4);
+
+        if (memcmp(id, kSaveStateEndID, 4) == 0)
+            break;
+
+        std::streampos start = stream.tellg();
+        int block = FindSaveStateBlock(id);
+
+        if (block >= 0)
+        {
+            LoadStateBlock(stream, block);
+
+            if (stream.fail() || ((stream.tellg() - start) != static_cast<std::streamoff> (size)))
+            {
+                Log("Error reading state block %.4s", id);
+                return false;
+            }
+        }
+
+        stream.seekg(start + std::streamoff(size));
+    }
+
+    m_pScheduler->Reset();
+    m_bPaused = false;
+
+    return true;
+}
+
+size_t GearboyCore::GetStateSize()
+{
+    MemoryStreamBuffer buffer(NULL, 0);
+    std::ostream stream(&buffer);
+
+    if (!SaveState(stream))
+        return 0;
+
+    return buffer.GetUsedSize();
+}
+
+bool GearboyCore::SaveStateToBuffer(u8* pBuffer, size_t size)
+{
+    if (!IsValidPointer(pBuffer))
+        return false;
+
+    MemoryStreamBuffer buffer(pBuffer, size);
+    std::ostream stream(&buffer);
+
+    return SaveState(stream);
+}
+
+bool GearboyCore::LoadStateFromBuffer(const u8* pBuffer, size_t size)
+{
+    if (!IsValidPointer(pBuffer))
+        return false;
+
+    MemoryStreamBuffer buffer(const_cast<u8*> (pBuffer), size);
+    std::istream stream(&buffer);
+
+    return LoadState(stream);
+}
+
 void GearboyCore::InitDMGPalette()
 {
-    m_DMGPalette[0].red = 0x87;
-    m_DMGPalette[0].green = 0x96;
-    m_DMGPalette[0].blue = 0x03;
-    m_DMGPalette[0].alpha = 0xFF;
+    GB_Color palette[4];
+
+    palette[0].red = 0x87;
+    palette[0].green = 0x96;
+    palette[0].blue = 0x03;
+    palette[0].alpha = 0xFF;
+
+    palette[1].red = 0x4d;
+    palette[1].green = 0x6b;
+    palette[1].blue = 0x03;
+    palette[1].alpha = 0xFF;
 
-    m_DMGPalette[1].red = 0x4d;
-    m_DMGPalette[1].green = 0x6b;
-    m_DMGPalette[1].blue = 0x03;
-    m_DMGPalette[1].alpha = 0xFF;
+    palette[2].red = 0x2b;
+    palette[2].green = 0x55;
+    palette[2].blue = 0x03;
+    palette[2].alpha = 0xFF;
 
-    m_DMGPalette[2].red = 0x2b;
-    m_DMGPalette[2].green = 0x55;
-    m_DMGPalette[2].blue = 0x03;
-    m_DMGPalette[2].alpha = 0xFF;
+    palette[3].red = 0x14;
+    palette[3].green = 0x44;
+    palette[3].blue = 0x03;
+    palette[3].alpha = 0xFF;
 
-    m_DMGPalette[3].red = 0x14;
-    m_DMGPalette[3].green = 0x44;
-    m_DMGPalette[3].blue = 0x03;
-    m_DMGPalette[3].alpha = 0xFF;
+    m_pVideo->SetDMGPalette(palette);
 }
 
 void GearboyCore::InitMemoryRules()
 {
-    m_pIORegistersMemoryRule = new IORegistersMemoryRule(m_pProcessor, m_pMemory, m_pVideo, m_pInput, m_pAudio);
+    m_pIORegistersMemoryRule = new IORegistersMemoryRule(m_pProcessor, m_pMemory, m_pVideo, m_pInput, m_pAudio, m_pScheduler);
 
     m_pCommonMemoryRule = new CommonMemoryRule(m_pMemory);
 
@@ -496,6 +901,7 @@ bool GearboyCore::AddMemoryRules()
     if (!notSupported)
     {
         m_pMemory->GetCurrentRule()->SetRamChangedCallback(m_pRamChangedCallback);
+        m_pMemory->GetCurrentRule()->SetRamDirty();
     }
 
     return !notSupported;
@@ -524,6 +930,7 @@ void GearboyCore::Reset(bool bCGB)
     m_pVideo->Reset(m_bCGB);
     m_pAudio->Reset(m_bCGB);
     m_pInput->Reset();
+    m_pScheduler->Reset();
     m_pCartridge->UpdateCurrentRTC();
     m_bRTCUpdateCount = 0;
 
@@ -539,13 +946,172 @@ void GearboyCore::Reset(bool bCGB)
     m_bPaused = false;
 }
 
-void GearboyCore::RenderDMGFrame(GB_Color* pFrameBuffer) const
+void GearboyCore::GetRamPath(const char* szPath, char* szFullPath)
 {
-    int pixels = GAMEBOY_WIDTH * GAMEBOY_HEIGHT;
-    const u8* pGameboyFrameBuffer = m_pVideo->GetFrameBuffer();
+    if (IsValidPointer(szPath))
+    {
+        strcpy(szFullPath, szPath);
+        strcat(szFullPath, "/");
+        strcat(szFullPath, m_pCartridge->GetFileName());
+    }
+    else
+    {
+        strcpy(szFullPath, m_pCartridge->GetFilePath());
+    }
+
+    strcat(szFullPath, ".gearboy");
+}
+
+bool GearboyCore::SubmitRam(const char* szPath, bool wait)
+{
+    if (m_pCartridge->IsLoadedROM() && m_pCartridge->HasBattery() && IsValidPointer(m_pMemory->GetCurrentRule()))
+    {
+        Log("Saving RAM...");
+
+        char path[512];
+
+        GetRamPath(szPath, path);
+
+        Log("Save file: %s", path);
+
+        MemoryRule* pRule = m_pMemory->GetCurrentRule();
+        bool samePath = (strcmp(path, m_szRamSavePath) == 0);
+
+        if (samePath && !pRule->IsRamDirty())
+        {
+            Log("RAM unchanged");
+        }
+        else
+        {
+            // the snapshot is taken here, the file is written by the worker
+            std::ostringstream stream;
+            pRule->SaveRam(stream);
 
-    for (int i = 0; i < pixels; i++)
+            std::string snapshot = stream.str();
+            m_pRamSaveWorker->Submit(path, reinterpret_cast<const u8*> (snapshot.data()), static_cast<int> (snapshot.size()), samePath ? pRule->GetRamDirtyPages() : NULL);
+
+            // a failed write keeps its snapshot queued as a full write,
+            // so later patches never skip the pages it carried
+            pRule->ClearRamDirty();
+            strcpy(m_szRamSavePath, path);
+        }
+
+        if (wait)
+        {
+            if (!m_pRamSaveWorker->Flush())
+            {
+                // the next save starts over from a full snapshot
+                pRule->SetRamDirty();
+                m_szRamSavePath[0] = 0;
+                Log("RAM save failed");
+                return false;
+            }
+
+            Log("RAM saved");
+        }
+    }
+
+    return true;
+}
+
+void GearboyCore::GetSaveStatePath(const char* szPath, int index, char* szFullPath)
+{
+    if (IsValidPointer(szPath))
     {
-        pFrameBuffer[i] = m_DMGPalette[pGameboyFrameBuffer[i]];
+        strcpy(szFullPath, szPath);
+        strcat(szFullPath, "/");
+        strcat(szFullPath, m_pCartridge->GetFileName());
+    }
+    else
+    {
+        strcpy(szFullPath, m_pCartridge->GetFilePath());
+    }
+
+    char extension[16];
+    sprintf(extension, ".state%d", index);
+    strcat(szFullPath, extension);
+}
+
+int GearboyCore::FindSaveStateBlock(const char* szID)
+{
+    for (int block = 0; block < StateBlockCount; block++)
+    {
+        if (memcmp(szID, kSaveStateBlockIDs[block], 4) == 0)
+            return block;
+    }
+
+    return -1;
+}
+
+void GearboyCore::SaveStateBlock(std::ostream& stream, int block)
+{
+    switch (block)
+    {
+        case CoreStateBlock:
+        {
+            stream.write(reinterpret_cast<const char*> (&m_iTotalClockCycles), sizeof(m_iTotalClockCycles));
+            stream.write(reinterpret_cast<const char*> (&m_bRTCUpdateCount), sizeof(m_bRTCUpdateCount));
+            break;
+        }
+        case ProcessorStateBlock:
+            m_pProcessor->SaveState(stream);
+            break;
+        case MemoryStateBlock:
+            m_pMemory->SaveState(stream);
+            break;
+        case VideoStateBlock:
+            m_pVideo->SaveState(stream);
+            break;
+        case AudioStateBlock:
+            m_pAudio->SaveState(stream);
+            break;
+        case InputStateBlock:
+            m_pInput->SaveState(stream);
+            break;
+        case MemoryRuleStateBlock:
+            m_pMemory->GetCurrentRule()->SaveState(stream);
+            break;
+    }
+}
+
+size_t GearboyCore::GetStateBlockSize(int block)
+{
+    MemoryStreamBuffer buffer(NULL, 0);
+    std::ostream stream(&buffer);
+
+    SaveStateBlock(stream, block);
+
+    return buffer.GetUsedSize();
+}
+
+void GearboyCore::LoadStateBlock(std::istream& stream, int block)
+{
+    switch (block)
+    {
+        case CoreStateBlock:
+        {
+            stream.read(reinterpret_cast<char*> (&m_iTotalClockCycles), sizeof(m_iTotalClockCycles));
+            stream.read(reinterpret_cast<char*> (&m_bRTCUpdateCount), sizeof(m_bRTCUpdateCount));
+            break;
+        }
+        case ProcessorStateBlock:
+            m_pProcessor->LoadState(stream);
+            break;
+        case MemoryStateBlock:
+            m_pMemory->LoadState(stream);
+            break;
+        case VideoStateBlock:
+            m_pVideo->LoadState(stream);
+            break;
+        case AudioStateBlock:
+            m_pAudio->LoadState(stream);
+            break;
+        case InputStateBlock:
+            m_pInput->LoadState(stream);
+            break;
+        case MemoryRuleStateBlock:
+            m_pMemory->GetCurrentRule()->LoadState(stream);
+            m_pMemory->GetCurrentRule()->SetRamDirty();
+            break;
     }
 }
@@ -26,8 +26,12 @@ class Memory;
 class Processor;
 class Video;
 class Audio;
+class AudioSink;
 class Input;
 class Cartridge;
+class Scheduler;
+class RewindBuffer;
+class RamSaveWorker;
 class CommonMemoryRule;
 class IORegistersMemoryRule;
 class RomOnlyMemoryRule;
@@ -44,7 +48,10 @@ public:
     GearboyCore();
     ~GearboyCore();
     void Init();
-    void RunToVBlank(GB_Color* pFrameBuffer);
+    void RunToVBlank(void* pFrameBuffer);
+    const u32* GetDirtyLines() const;
+    bool IsFrameDirty() const;
+    bool IsFrameComplete() const;
     bool LoadROM(const char* szFilePath, bool forceDMG);
     Memory* GetMemory();
     Cartridge* GetCartridge();
@@ -53,22 +60,48 @@ public:
     void Pause(bool paused);
     bool IsPaused();
     void ResetROM(bool forceDMG);
+    void EnableRewind(bool enabled);
+    void SetRewindParameters(int bufferSize, int maxSnapshots, int frameInterval, int keyframeInterval);
+    bool Rewind(int snapshots = 1);
+    int GetRewindSnapshotCount();
     void EnableSound(bool enabled);
     void ResetSound(bool soft = false);
     void SetSoundSampleRate(int rate);
+    void SetSpeed(int multiplier);
+    void SetAudioSink(AudioSink* pSink);
     void SetDMGPalette(GB_Color& color1, GB_Color& color2, GB_Color& color3, GB_Color& color4);
-    void SaveRam();
-    void SaveRam(const char* szPath);
+    void SetColorCorrection(Gameboy_Color_Correction correction);
+    void SetPixelFormat(Gameboy_Pixel_Format format, int pitch = 0);
+    bool SaveRam();
+    bool SaveRam(const char* szPath);
+    void SaveRamAsync();
+    void SaveRamAsync(const char* szPath);
     void LoadRam();
     void LoadRam(const char* szPath);
     void SetRamModificationCallback(RamChangedCallback callback);
+    bool SaveState(int index);
+    bool SaveState(const char* szPath, int index);
+    bool SaveState(std::ostream& stream);
+    bool LoadState(int index);
+    bool LoadState(const char* szPath, int index);
+    bool LoadState(std::istream& stream);
+    size_t GetStateSize();
+    bool SaveStateToBuffer(u8* pBuffer, size_t size);
+    bool LoadStateFromBuffer(const u8* pBuffer, size_t size);
+    u64 GetTotalClockCycles() const;
 
 private:
     void InitDMGPalette();
     void InitMemoryRules();
     bool AddMemoryRules();
     void Reset(bool bCGB);
-    void RenderDMGFrame(GB_Color* pFrameBuffer) const;
+    void GetSaveStatePath(const char* szPath, int index, char* szFullPath);
+    void GetRamPath(const char* szPath, char* szFullPath);
+    bool SubmitRam(const char* szPath, bool wait);
+    int FindSaveStateBlock(const char* szID);
+    void SaveStateBlock(std::ostream& stream, int block);
+    size_t GetStateBlockSize(int block);
+    void LoadStateBlock(std::istream& stream, int block);
 
 private:
     Memory* m_pMemory;
@@ -77,6 +110,9 @@ private:
     Audio* m_pAudio;
     Input* m_pInput;
     Cartridge* m_pCartridge;
+    Scheduler* m_pScheduler;
+    RewindBuffer* m_pRewindBuffer;
+    RamSaveWorker* m_pRamSaveWorker;
     CommonMemoryRule* m_pCommonMemoryRule;
     IORegistersMemoryRule* m_pIORegistersMemoryRule;
     RomOnlyMemoryRule* m_pRomOnlyMemoryRule;
@@ -87,13 +123,14 @@ private:
     MultiMBC1MemoryRule* m_pMultiMBC1MemoryRule;
     bool m_bCGB;
     bool m_bPaused;
-    GB_Color m_DMGPalette[4];
     bool m_bForceDMG;
     int m_bRTCUpdateCount;
     bool m_bDuringBootROM;
     bool m_bLoadRamPending;
     char m_szLoadRamPendingPath[512];
+    char m_szRamSavePath[512];
     RamChangedCallback m_pRamChangedCallback;
+    u64 m_iTotalClockCycles;
 };
 
 #endif	/* CORE_H */
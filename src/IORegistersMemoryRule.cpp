@@ -20,13 +20,14 @@
 #include "IORegistersMemoryRule.h"
 
 IORegistersMemoryRule::IORegistersMemoryRule(Processor* pProcessor,
-        Memory* pMemory, Video* pVideo, Input* pInput, Audio* pAudio)
+        Memory* pMemory, Video* pVideo, Input* pInput, Audio* pAudio, Scheduler* pScheduler)
 {
     m_pProcessor = pProcessor;
     m_pMemory = pMemory;
     m_pVideo = pVideo;
     m_pInput = pInput;
     m_pAudio = pAudio;
+    m_pScheduler = pScheduler;
     m_bCGB = false;
 }
 
@@ -27,11 +27,12 @@ class Processor;
 class Input;
 class Audio;
 class Memory;
+class Scheduler;
 
 class IORegistersMemoryRule
 {
 public:
-    IORegistersMemoryRule(Processor* pProcessor, Memory* pMemory, Video* pVideo, Input* pInput, Audio* pAudio);
+    IORegistersMemoryRule(Processor* pProcessor, Memory* pMemory, Video* pVideo, Input* pInput, Audio* pAudio, Scheduler* pScheduler);
     ~IORegistersMemoryRule();
     u8 PerformRead(u16 address);
     void PerformWrite(u16 address, u8 value);
@@ -43,6 +44,7 @@ private:
     Video* m_pVideo;
     Input* m_pInput;
     Audio* m_pAudio;
+    Scheduler* m_pScheduler;
     bool m_bCGB;
 };
 
@@ -51,6 +53,7 @@ private:
 #include "Input.h"
 #include "Audio.h"
 #include "Memory.h"
+#include "Scheduler.h"
 
 inline u8 IORegistersMemoryRule::PerformRead(u16 address)
 {
@@ -66,6 +69,13 @@ inline u8 IORegistersMemoryRule::PerformRead(u16 address)
             // UNDOCUMENTED
             return 0xFF;
         }
+        case 0xFF04:
+        case 0xFF05:
+        {
+            // DIV, TIMA
+            m_pScheduler->Synchronize();
+            return m_pMemory->Retrieve(address);
+        }
         case 0xFF07:
         {
             // TAC
@@ -137,6 +147,7 @@ inline u8 IORegistersMemoryRule::PerformRead(u16 address)
         case 0xFF3F:
         {
             // SOUND REGISTERS
+            m_pScheduler->Synchronize();
             return m_pAudio->ReadAudioRegister(address);
         }
         case 0xFF41:
@@ -225,15 +236,31 @@ inline void IORegistersMemoryRule::PerformWrite(u16 address, u8 value)
             m_pInput->Write(value);
             break;
         }
+        case 0xFF02:
+        {
+            // SC
+            m_pScheduler->Synchronize();
+            m_pMemory->Load(address, value);
+            break;
+        }
         case 0xFF04:
         {
             // DIV
+            m_pScheduler->Synchronize();
             m_pProcessor->ResetDIVCycles();
             break;
         }
+        case 0xFF05:
+        {
+            // TIMA
+            m_pScheduler->Synchronize();
+            m_pMemory->Load(address, value);
+            break;
+        }
         case 0xFF07:
         {
             // TAC
+            m_pScheduler->Synchronize();
             value &= 0x07;
             u8 current_tac = m_pMemory->Retrieve(0xFF07);
             if ((current_tac & 0x03) != (value & 0x03))
@@ -299,12 +326,14 @@ inline void IORegistersMemoryRule::PerformWrite(u16 address, u8 value)
         case 0xFF3F:
         {
             // SOUND REGISTERS
+            m_pScheduler->Synchronize();
             m_pAudio->WriteAudioRegister(address, value);
             break;
         }
         case 0xFF40:
         {
             // LCDC
+            m_pScheduler->Synchronize();
             u8 current_lcdc = m_pMemory->Retrieve(0xFF40);
             u8 new_lcdc = value;
             m_pMemory->Load(address, new_lcdc);
@@ -361,6 +390,7 @@ inline void IORegistersMemoryRule::PerformWrite(u16 address, u8 value)
         case 0xFF44:
         {
             // LY
+            m_pScheduler->Synchronize();
             u8 current_ly = m_pMemory->Retrieve(0xFF44);
             if (IsSetBit(current_ly, 7) && !IsSetBit(value, 7))
             {
@@ -393,6 +423,7 @@ inline void IORegistersMemoryRule::PerformWrite(u16 address, u8 value)
         case 0xFF4D:
         {
             // KEY1
+            m_pScheduler->Synchronize();
             if (m_bCGB)
             {
                 u8 current_key1 = m_pMemory->Retrieve(0xFF4D);
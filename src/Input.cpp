@@ -80,3 +80,17 @@ void Input::Update()
 
     m_P1 = current;
 }
+
+void Input::SaveState(std::ostream& stream)
+{
+    stream.write(reinterpret_cast<const char*> (&m_JoypadState), sizeof(m_JoypadState));
+    stream.write(reinterpret_cast<const char*> (&m_P1), sizeof(m_P1));
+    stream.write(reinterpret_cast<const char*> (&m_iInputCycles), sizeof(m_iInputCycles));
+}
+
+void Input::LoadState(std::istream& stream)
+{
+    stream.read(reinterpret_cast<char*> (&m_JoypadState), sizeof(m_JoypadState));
+    stream.read(reinterpret_cast<char*> (&m_P1), sizeof(m_P1));
+    stream.read(reinterpret_cast<char*> (&m_iInputCycles), sizeof(m_iInputCycles));
+}
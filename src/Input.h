@@ -32,10 +32,13 @@ public:
     void Init();
     void Reset();
     void Tick(unsigned int clockCycles);
+    int GetNextEventCycles() const;
     void KeyPressed(Gameboy_Keys key);
     void KeyReleased(Gameboy_Keys key);
     void Write(u8 value);
     u8 Read();
+    void SaveState(std::ostream& stream);
+    void LoadState(std::istream& stream);
 
 private:
     void Update();
@@ -60,6 +63,11 @@ inline void Input::Tick(unsigned int clockCycles)
     }
 }
 
+inline int Input::GetNextEventCycles() const
+{
+    return 65536 - m_iInputCycles;
+}
+
 inline void Input::Write(u8 value)
 {
     m_P1 = (m_P1 & 0xCF) | (value & 0x30);
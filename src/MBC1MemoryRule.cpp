@@ -114,6 +114,7 @@ void MBC1MemoryRule::PerformWrite(u16 address, u8 value)
 
             m_iCurrentROMBank &= (m_pCartridge->GetROMBankCount() - 1);
             m_CurrentROMAddress = m_iCurrentROMBank * 0x4000;
+            UpdateMemoryMap();
             break;
         }
         case 0x4000:
@@ -135,6 +136,7 @@ void MBC1MemoryRule::PerformWrite(u16 address, u8 value)
 
                 m_iCurrentROMBank &= (m_pCartridge->GetROMBankCount() - 1);
                 m_CurrentROMAddress = m_iCurrentROMBank * 0x4000;
+                UpdateMemoryMap();
             }
             break;
         }
@@ -163,9 +165,13 @@ void MBC1MemoryRule::PerformWrite(u16 address, u8 value)
                     }
 
                     m_pRAMBanks[address - 0xA000] = value;
+                    MarkRamDirty(address - 0xA000);
                 }
                 else
+                {
                     m_pRAMBanks[(address - 0xA000) + m_CurrentRAMAddress] = value;
+                    MarkRamDirty((address - 0xA000) + m_CurrentRAMAddress);
+                }
             }
             else
             {
@@ -195,18 +201,19 @@ void MBC1MemoryRule::Reset(bool bCGB)
     m_CurrentRAMAddress = 0;
 }
 
-void MBC1MemoryRule::SaveRam(std::ofstream &file)
+void MBC1MemoryRule::UpdateMemoryMap()
+{
+    m_pMemory->MapROM(m_pMemory->GetMemoryMap(), m_pCartridge->GetTheROM() + m_CurrentROMAddress);
+}
+
+void MBC1MemoryRule::SaveRam(std::ostream &file)
 {
     Log("MBC1MemoryRule save RAM...");
     Log("MBC1MemoryRule saving %d banks...", m_pCartridge->GetRAMBankCount());
     
     u32 ramSize = m_pCartridge->GetRAMBankCount() * 0x2000;
 
-    for (u32 i = 0; i < ramSize; i++)
-    {
-        u8 ram_byte = m_pRAMBanks[i];
-        file.write(reinterpret_cast<const char*> (&ram_byte), 1);
-    }
+    file.write(reinterpret_cast<const char*> (m_pRAMBanks), ramSize);
 
     Log("MBC1MemoryRule save RAM done");
 }
@@ -242,3 +249,29 @@ bool MBC1MemoryRule::LoadRam(std::ifstream &file, s32 fileSize)
     
     return true;
 }
+
+void MBC1MemoryRule::SaveState(std::ostream& stream)
+{
+    stream.write(reinterpret_cast<const char*> (&m_iMode), sizeof(m_iMode));
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentRAMBank), sizeof(m_iCurrentRAMBank));
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.write(reinterpret_cast<const char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+    stream.write(reinterpret_cast<const char*> (&m_HigherRomBankBits), sizeof(m_HigherRomBankBits));
+    stream.write(reinterpret_cast<const char*> (&m_CurrentROMAddress), sizeof(m_CurrentROMAddress));
+    stream.write(reinterpret_cast<const char*> (&m_CurrentRAMAddress), sizeof(m_CurrentRAMAddress));
+    stream.write(reinterpret_cast<const char*> (m_pRAMBanks), kMBC1RamBanksSize);
+}
+
+void MBC1MemoryRule::LoadState(std::istream& stream)
+{
+    stream.read(reinterpret_cast<char*> (&m_iMode), sizeof(m_iMode));
+    stream.read(reinterpret_cast<char*> (&m_iCurrentRAMBank), sizeof(m_iCurrentRAMBank));
+    stream.read(reinterpret_cast<char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.read(reinterpret_cast<char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+    stream.read(reinterpret_cast<char*> (&m_HigherRomBankBits), sizeof(m_HigherRomBankBits));
+    stream.read(reinterpret_cast<char*> (&m_CurrentROMAddress), sizeof(m_CurrentROMAddress));
+    stream.read(reinterpret_cast<char*> (&m_CurrentRAMAddress), sizeof(m_CurrentRAMAddress));
+    stream.read(reinterpret_cast<char*> (m_pRAMBanks), kMBC1RamBanksSize);
+
+    UpdateMemoryMap();
+}
@@ -102,6 +102,7 @@ void MBC2MemoryRule::PerformWrite(u16 address, u8 value)
                     m_iCurrentROMBank = 1;
                 m_iCurrentROMBank &= (m_pCartridge->GetROMBankCount() - 1);
                 m_CurrentROMAddress = m_iCurrentROMBank * 0x4000;
+                UpdateMemoryMap();
             }
             else
             {
@@ -122,6 +123,7 @@ void MBC2MemoryRule::PerformWrite(u16 address, u8 value)
                 if (m_bRamEnabled)
                 {
                     m_pMemory->Load(address, value & 0x0F);
+                    MarkRamDirty(address - 0xA000);
                 }
                 else
                 {
@@ -150,7 +152,12 @@ void MBC2MemoryRule::Reset(bool bCGB)
     m_bRamEnabled = false;
 }
 
-void MBC2MemoryRule::SaveRam(std::ofstream & file)
+void MBC2MemoryRule::UpdateMemoryMap()
+{
+    m_pMemory->MapROM(m_pMemory->GetMemoryMap(), m_pCartridge->GetTheROM() + m_CurrentROMAddress);
+}
+
+void MBC2MemoryRule::SaveRam(std::ostream & file)
 {
     Log("MBC2MemoryRule save RAM...");
 
@@ -184,3 +191,19 @@ bool MBC2MemoryRule::LoadRam(std::ifstream & file, s32 fileSize)
     
     return true;
 }
+
+void MBC2MemoryRule::SaveState(std::ostream& stream)
+{
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.write(reinterpret_cast<const char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+    stream.write(reinterpret_cast<const char*> (&m_CurrentROMAddress), sizeof(m_CurrentROMAddress));
+}
+
+void MBC2MemoryRule::LoadState(std::istream& stream)
+{
+    stream.read(reinterpret_cast<char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.read(reinterpret_cast<char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+    stream.read(reinterpret_cast<char*> (&m_CurrentROMAddress), sizeof(m_CurrentROMAddress));
+
+    UpdateMemoryMap();
+}
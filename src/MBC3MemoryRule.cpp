@@ -124,6 +124,7 @@ void MBC3MemoryRule::PerformWrite(u16 address, u8 value)
                 m_iCurrentROMBank = 1;
             m_iCurrentROMBank &= (m_pCartridge->GetROMBankCount() - 1);
             m_CurrentROMAddress = m_iCurrentROMBank * 0x4000;
+            UpdateMemoryMap();
             break;
         }
         case 0x4000:
@@ -166,6 +167,7 @@ void MBC3MemoryRule::PerformWrite(u16 address, u8 value)
                     m_iRTCLatchedHours = m_iRTCHours;
                     m_iRTCLatchedDays = m_iRTCDays;
                     m_iRTCLatchedControl = m_iRTCControl;
+                    MarkRamDirty(kMBC3RTCSaveOffset);
                 }
                 if ((value == 0x00) || (value == 0x01))
                 {
@@ -181,6 +183,7 @@ void MBC3MemoryRule::PerformWrite(u16 address, u8 value)
                 if (m_bRamEnabled)
                 {
                     m_pRAMBanks[(address - 0xA000) + m_CurrentRAMAddress] = value;
+                    MarkRamDirty((address - 0xA000) + m_CurrentRAMAddress);
                 }
                 else
                 {
@@ -190,6 +193,7 @@ void MBC3MemoryRule::PerformWrite(u16 address, u8 value)
             else if (m_pCartridge->IsRTCPresent() && m_bRTCEnabled)
             {
                 m_RTCLastTime = static_cast<s32>(m_pCartridge->GetCurrentRTC());
+                MarkRamDirty(kMBC3RTCSaveOffset);
                 switch (m_RTCRegister)
                 {
                     case 0x08:
@@ -253,15 +257,16 @@ void MBC3MemoryRule::Reset(bool bCGB)
     m_CurrentRAMAddress = 0;
 }
 
-void MBC3MemoryRule::SaveRam(std::ofstream & file)
+void MBC3MemoryRule::UpdateMemoryMap()
+{
+    m_pMemory->MapROM(m_pMemory->GetMemoryMap(), m_pCartridge->GetTheROM() + m_CurrentROMAddress);
+}
+
+void MBC3MemoryRule::SaveRam(std::ostream & file)
 {
     Log("MBC3MemoryRule save RAM...");
 
-    for (int i = 0; i < 0x8000; i++)
-    {
-        u8 ram_byte = m_pRAMBanks[i];
-        file.write(reinterpret_cast<const char*> (&ram_byte), 1);
-    }
+    file.write(reinterpret_cast<const char*> (m_pRAMBanks), kMBC3RTCSaveOffset);
 
     if (m_pCartridge->IsRTCPresent())
     {
@@ -354,6 +359,7 @@ void MBC3MemoryRule::UpdateRTC()
     if (m_RTCLastTimeCache != now)
     {
         m_RTCLastTimeCache = now;
+        MarkRamDirty(kMBC3RTCSaveOffset);
         s32 difference = now - m_RTCLastTime;
         if (difference > 0)
         {
@@ -397,3 +403,55 @@ void MBC3MemoryRule::UpdateRTC()
         m_RTCLastTime = now;
     }
 }
+
+void MBC3MemoryRule::SaveState(std::ostream& stream)
+{
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentRAMBank), sizeof(m_iCurrentRAMBank));
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.write(reinterpret_cast<const char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+    stream.write(reinterpret_cast<const char*> (&m_bRTCEnabled), sizeof(m_bRTCEnabled));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCSeconds), sizeof(m_iRTCSeconds));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCMinutes), sizeof(m_iRTCMinutes));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCHours), sizeof(m_iRTCHours));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCDays), sizeof(m_iRTCDays));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCControl), sizeof(m_iRTCControl));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCLatchedSeconds), sizeof(m_iRTCLatchedSeconds));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCLatchedMinutes), sizeof(m_iRTCLatchedMinutes));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCLatchedHours), sizeof(m_iRTCLatchedHours));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCLatchedDays), sizeof(m_iRTCLatchedDays));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCLatchedControl), sizeof(m_iRTCLatchedControl));
+    stream.write(reinterpret_cast<const char*> (&m_iRTCLatch), sizeof(m_iRTCLatch));
+    stream.write(reinterpret_cast<const char*> (&m_RTCRegister), sizeof(m_RTCRegister));
+    stream.write(reinterpret_cast<const char*> (&m_RTCLastTime), sizeof(m_RTCLastTime));
+    stream.write(reinterpret_cast<const char*> (&m_RTCLastTimeCache), sizeof(m_RTCLastTimeCache));
+    stream.write(reinterpret_cast<const char*> (&m_CurrentROMAddress), sizeof(m_CurrentROMAddress));
+    stream.write(reinterpret_cast<const char*> (&m_CurrentRAMAddress), sizeof(m_CurrentRAMAddress));
+    stream.write(reinterpret_cast<const char*> (m_pRAMBanks), 0x8000);
+}
+
+void MBC3MemoryRule::LoadState(std::istream& stream)
+{
+    stream.read(reinterpret_cast<char*> (&m_iCurrentRAMBank), sizeof(m_iCurrentRAMBank));
+    stream.read(reinterpret_cast<char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.read(reinterpret_cast<char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+    stream.read(reinterpret_cast<char*> (&m_bRTCEnabled), sizeof(m_bRTCEnabled));
+    stream.read(reinterpret_cast<char*> (&m_iRTCSeconds), sizeof(m_iRTCSeconds));
+    stream.read(reinterpret_cast<char*> (&m_iRTCMinutes), sizeof(m_iRTCMinutes));
+    stream.read(reinterpret_cast<char*> (&m_iRTCHours), sizeof(m_iRTCHours));
+    stream.read(reinterpret_cast<char*> (&m_iRTCDays), sizeof(m_iRTCDays));
+    stream.read(reinterpret_cast<char*> (&m_iRTCControl), sizeof(m_iRTCControl));
+    stream.read(reinterpret_cast<char*> (&m_iRTCLatchedSeconds), sizeof(m_iRTCLatchedSeconds));
+    stream.read(reinterpret_cast<char*> (&m_iRTCLatchedMinutes), sizeof(m_iRTCLatchedMinutes));
+    stream.read(reinterpret_cast<char*> (&m_iRTCLatchedHours), sizeof(m_iRTCLatchedHours));
+    stream.read(reinterpret_cast<char*> (&m_iRTCLatchedDays), sizeof(m_iRTCLatchedDays));
+    stream.read(reinterpret_cast<char*> (&m_iRTCLatchedControl), sizeof(m_iRTCLatchedControl));
+    stream.read(reinterpret_cast<char*> (&m_iRTCLatch), sizeof(m_iRTCLatch));
+    stream.read(reinterpret_cast<char*> (&m_RTCRegister), sizeof(m_RTCRegister));
+    stream.read(reinterpret_cast<char*> (&m_RTCLastTime), sizeof(m_RTCLastTime));
+    stream.read(reinterpret_cast<char*> (&m_RTCLastTimeCache), sizeof(m_RTCLastTimeCache));
+    stream.read(reinterpret_cast<char*> (&m_CurrentROMAddress), sizeof(m_CurrentROMAddress));
+    stream.read(reinterpret_cast<char*> (&m_CurrentRAMAddress), sizeof(m_CurrentRAMAddress));
+    stream.read(reinterpret_cast<char*> (m_pRAMBanks), 0x8000);
+
+    UpdateMemoryMap();
+}
@@ -98,6 +98,7 @@ void MBC5MemoryRule::PerformWrite(u16 address, u8 value)
             }
             m_iCurrentROMBank &= (m_pCartridge->GetROMBankCount() - 1);
             m_CurrentROMAddress = m_iCurrentROMBank * 0x4000;
+            UpdateMemoryMap();
             break;
         }
         case 0x4000:
@@ -117,6 +118,7 @@ void MBC5MemoryRule::PerformWrite(u16 address, u8 value)
             if (m_bRamEnabled)
             {
                 m_pRAMBanks[(address - 0xA000) + m_CurrentRAMAddress] = value;
+                MarkRamDirty((address - 0xA000) + m_CurrentRAMAddress);
             }
             else
             {
@@ -145,18 +147,19 @@ void MBC5MemoryRule::Reset(bool bCGB)
     m_CurrentRAMAddress = 0;
 }
 
-void MBC5MemoryRule::SaveRam(std::ofstream & file)
+void MBC5MemoryRule::UpdateMemoryMap()
+{
+    m_pMemory->MapROM(m_pMemory->GetMemoryMap(), m_pCartridge->GetTheROM() + m_CurrentROMAddress);
+}
+
+void MBC5MemoryRule::SaveRam(std::ostream & file)
 {
     Log("MBC5MemoryRule save RAM...");
     Log("MBC5MemoryRule saving %d banks...", m_pCartridge->GetRAMBankCount());
     
     s32 ramSize = m_pCartridge->GetRAMBankCount() * 0x2000;
 
-    for (s32 i = 0; i < ramSize; i++)
-    {
-        u8 ram_byte = m_pRAMBanks[i];
-        file.write(reinterpret_cast<const char*> (&ram_byte), 1);
-    }
+    file.write(reinterpret_cast<const char*> (m_pRAMBanks), ramSize);
 
     Log("MBC5MemoryRule save RAM done");
 }
@@ -185,3 +188,27 @@ bool MBC5MemoryRule::LoadRam(std::ifstream & file, s32 fileSize)
     
     return true;
 }
+
+void MBC5MemoryRule::SaveState(std::ostream& stream)
+{
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentRAMBank), sizeof(m_iCurrentRAMBank));
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentROMBankHi), sizeof(m_iCurrentROMBankHi));
+    stream.write(reinterpret_cast<const char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+    stream.write(reinterpret_cast<const char*> (&m_CurrentROMAddress), sizeof(m_CurrentROMAddress));
+    stream.write(reinterpret_cast<const char*> (&m_CurrentRAMAddress), sizeof(m_CurrentRAMAddress));
+    stream.write(reinterpret_cast<const char*> (m_pRAMBanks), m_pCartridge->GetRAMBankCount() * 0x2000);
+}
+
+void MBC5MemoryRule::LoadState(std::istream& stream)
+{
+    stream.read(reinterpret_cast<char*> (&m_iCurrentRAMBank), sizeof(m_iCurrentRAMBank));
+    stream.read(reinterpret_cast<char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.read(reinterpret_cast<char*> (&m_iCurrentROMBankHi), sizeof(m_iCurrentROMBankHi));
+    stream.read(reinterpret_cast<char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+    stream.read(reinterpret_cast<char*> (&m_CurrentROMAddress), sizeof(m_CurrentROMAddress));
+    stream.read(reinterpret_cast<char*> (&m_CurrentRAMAddress), sizeof(m_CurrentRAMAddress));
+    stream.read(reinterpret_cast<char*> (m_pRAMBanks), m_pCartridge->GetRAMBankCount() * 0x2000);
+
+    UpdateMemoryMap();
+}
@@ -44,6 +44,11 @@ Memory::Memory()
     m_HDMASource = 0;
     m_HDMADestination = 0;
     m_bDuringBootROM = false;
+    for (int i = 0; i < 16; i++)
+    {
+        InitPointer(m_pReadPages[i]);
+        InitPointer(m_pWritePages[i]);
+    }
 }
 
 Memory::~Memory()
@@ -168,11 +173,26 @@ void Memory::Reset(bool bCGB, bool bootROM)
         m_HDMADestination = ((hdma3 & 0x1F) << 8) | (hdma4 & 0xF0);
         m_HDMADestination |= 0x8000;
     }
+
+    // ROM and cartridge RAM pages are mapped by the current rule,
+    // 0xF000-0xFFFF always goes through the slow path
+    for (int i = 0; i < 16; i++)
+    {
+        InitPointer(m_pReadPages[i]);
+        InitPointer(m_pWritePages[i]);
+    }
+
+    m_pReadPages[0x8] = m_pWritePages[0x8] = m_pMap + 0x8000;
+    m_pReadPages[0x9] = m_pWritePages[0x9] = m_pMap + 0x9000;
+    m_pReadPages[0xC] = m_pMap + 0xC000;
+    m_pReadPages[0xD] = m_bCGB ? m_pWRAMBanks + (0x1000 * m_iCurrentWRAMBank) : m_pMap + 0xD000;
+    m_pReadPages[0xE] = m_pMap + 0xE000;
 }
 
 void Memory::SetCurrentRule(MemoryRule* pRule)
 {
     m_pCurrentMemoryRule = pRule;
+    m_pCurrentMemoryRule->UpdateMemoryMap();
 }
 
 void Memory::SetCommonRule(CommonMemoryRule* pRule)
@@ -204,6 +224,24 @@ void Memory::LoadBank0and1FromROM(u8* pTheROM)
     }
 }
 
+u8* Memory::GetMemoryMap()
+{
+    return m_pMap;
+}
+
+void Memory::MapROM(u8* pBank0, u8* pBank1)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        m_pReadPages[i] = pBank0 + (0x1000 * i);
+        m_pReadPages[i + 4] = pBank1 + (0x1000 * i);
+    }
+
+    // the boot ROM overlaps the first page
+    if (m_bDuringBootROM)
+        InitPointer(m_pReadPages[0]);
+}
+
 void Memory::MemoryDump(const char* szFilePath)
 {
     using namespace std;
@@ -419,3 +457,37 @@ u8 Memory::GetHDMARegister(int reg)
     return m_HDMA[reg - 1];
 }
 
+void Memory::SaveState(std::ostream& stream)
+{
+    stream.write(reinterpret_cast<const char*> (m_pMap), 0x10000);
+    stream.write(reinterpret_cast<const char*> (m_pWRAMBanks), 0x8000);
+    stream.write(reinterpret_cast<const char*> (m_pLCDRAMBank1), 0x2000);
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentWRAMBank), sizeof(m_iCurrentWRAMBank));
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentLCDRAMBank), sizeof(m_iCurrentLCDRAMBank));
+    stream.write(reinterpret_cast<const char*> (&m_bHDMAEnabled), sizeof(m_bHDMAEnabled));
+    stream.write(reinterpret_cast<const char*> (&m_iHDMABytes), sizeof(m_iHDMABytes));
+    stream.write(reinterpret_cast<const char*> (m_HDMA), sizeof(m_HDMA));
+    stream.write(reinterpret_cast<const char*> (&m_HDMASource), sizeof(m_HDMASource));
+    stream.write(reinterpret_cast<const char*> (&m_HDMADestination), sizeof(m_HDMADestination));
+}
+
+void Memory::LoadState(std::istream& stream)
+{
+    stream.read(reinterpret_cast<char*> (m_pMap), 0x10000);
+    stream.read(reinterpret_cast<char*> (m_pWRAMBanks), 0x8000);
+    stream.read(reinterpret_cast<char*> (m_pLCDRAMBank1), 0x2000);
+    stream.read(reinterpret_cast<char*> (&m_iCurrentWRAMBank), sizeof(m_iCurrentWRAMBank));
+    stream.read(reinterpret_cast<char*> (&m_iCurrentLCDRAMBank), sizeof(m_iCurrentLCDRAMBank));
+    stream.read(reinterpret_cast<char*> (&m_bHDMAEnabled), sizeof(m_bHDMAEnabled));
+    stream.read(reinterpret_cast<char*> (&m_iHDMABytes), sizeof(m_iHDMABytes));
+    stream.read(reinterpret_cast<char*> (m_HDMA), sizeof(m_HDMA));
+    stream.read(reinterpret_cast<char*> (&m_HDMASource), sizeof(m_HDMASource));
+    stream.read(reinterpret_cast<char*> (&m_HDMADestination), sizeof(m_HDMADestination));
+
+    if (m_bCGB)
+    {
+        SwitchCGBWRAM(m_iCurrentWRAMBank);
+        SwitchCGBLCDRAM(m_iCurrentLCDRAMBank);
+    }
+}
+
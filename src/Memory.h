@@ -56,6 +56,8 @@ public:
     void Disassemble(u16 address, const char* szDisassembled);
     bool IsDisassembled(u16 address);
     void LoadBank0and1FromROM(u8* pTheROM);
+    u8* GetMemoryMap();
+    void MapROM(u8* pBank0, u8* pBank1);
     void MemoryDump(const char* szFilePath);
     void PerformDMA(u8 value);
     void SwitchCGBDMA(u8 value);
@@ -64,6 +66,8 @@ public:
     bool IsHDMAEnabled();
     void SetHDMARegister(int reg, u8 value);
     u8 GetHDMARegister(int reg);
+    void SaveState(std::ostream& stream);
+    void LoadState(std::istream& stream);
 
 private:
 
@@ -91,6 +95,8 @@ private:
     u16 m_HDMASource;
     u16 m_HDMADestination;
     bool m_bDuringBootROM;
+    u8* m_pReadPages[16];
+    u8* m_pWritePages[16];
 };
 
 #include "Memory_inline.h"
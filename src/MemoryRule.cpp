@@ -18,6 +18,7 @@
  */
 
 #include "MemoryRule.h"
+#include "Memory.h"
 
 MemoryRule::MemoryRule(Processor* pProcessor, Memory* pMemory,
         Video* pVideo, Input* pInput, Cartridge* pCartridge, Audio* pAudio)
@@ -30,6 +31,7 @@ MemoryRule::MemoryRule(Processor* pProcessor, Memory* pMemory,
     m_pAudio = pAudio;
     m_bCGB = false;
     InitPointer(m_pRamChangedCallback);
+    SetRamDirty();
 }
 
 MemoryRule::~MemoryRule()
@@ -37,7 +39,13 @@ MemoryRule::~MemoryRule()
 
 }
 
-void MemoryRule::SaveRam(std::ofstream&)
+void MemoryRule::UpdateMemoryMap()
+{
+    u8* pMap = m_pMemory->GetMemoryMap();
+    m_pMemory->MapROM(pMap, pMap + 0x4000);
+}
+
+void MemoryRule::SaveRam(std::ostream&)
 {
     Log("Save RAM not implemented");
 }
@@ -48,7 +56,40 @@ bool MemoryRule::LoadRam(std::ifstream&, s32)
     return false;
 }
 
+void MemoryRule::SaveState(std::ostream&)
+{
+}
+
+void MemoryRule::LoadState(std::istream&)
+{
+}
+
 void MemoryRule::SetRamChangedCallback(RamChangedCallback callback)
 {
     m_pRamChangedCallback = callback;
 }
+
+bool MemoryRule::IsRamDirty() const
+{
+    return m_bRamDirty;
+}
+
+const u8* MemoryRule::GetRamDirtyPages() const
+{
+    // no page list when the whole RAM has to be written
+    return m_bRamDirtyAll ? NULL : m_RamDirtyPages;
+}
+
+void MemoryRule::SetRamDirty()
+{
+    memset(m_RamDirtyPages, 1, kRamDirtyPageCount);
+    m_bRamDirty = true;
+    m_bRamDirtyAll = true;
+}
+
+void MemoryRule::ClearRamDirty()
+{
+    memset(m_RamDirtyPages, 0, kRamDirtyPageCount);
+    m_bRamDirty = false;
+    m_bRamDirtyAll = false;
+}
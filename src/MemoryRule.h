@@ -30,6 +30,9 @@ class Input;
 class Cartridge;
 class Audio;
 
+const int kRamDirtyPageShift = 8;
+const int kRamDirtyPageCount = 0x200;
+
 class MemoryRule
 {
 public:
@@ -39,9 +42,19 @@ public:
     virtual u8 PerformRead(u16 address) = 0;
     virtual void PerformWrite(u16 address, u8 value) = 0;
     virtual void Reset(bool bCGB) = 0;
-    virtual void SaveRam(std::ofstream &file);
+    virtual void UpdateMemoryMap();
+    virtual void SaveRam(std::ostream &file);
     virtual bool LoadRam(std::ifstream &file, s32 fileSize);
     virtual void SetRamChangedCallback(RamChangedCallback callback);
+    virtual void SaveState(std::ostream& stream);
+    virtual void LoadState(std::istream& stream);
+    bool IsRamDirty() const;
+    const u8* GetRamDirtyPages() const;
+    void SetRamDirty();
+    void ClearRamDirty();
+
+protected:
+    void MarkRamDirty(int offset);
 
 protected:
     Processor* m_pProcessor;
@@ -52,7 +65,16 @@ protected:
     Audio* m_pAudio;
     bool m_bCGB;
     RamChangedCallback m_pRamChangedCallback;
+    u8 m_RamDirtyPages[kRamDirtyPageCount];
+    bool m_bRamDirty;
+    bool m_bRamDirtyAll;
 };
 
+inline void MemoryRule::MarkRamDirty(int offset)
+{
+    m_RamDirtyPages[offset >> kRamDirtyPageShift] = 1;
+    m_bRamDirty = true;
+}
+
 #endif	/* MEMORYRULE_H */
 
@@ -0,0 +1,147 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/
+ *
+ */
+
+#ifndef MEMORYSTREAMBUFFER_H
+#define	MEMORYSTREAMBUFFER_H
+
+#include <streambuf>
+#include "definitions.h"
+
+// seekable stream buffer over caller owned memory, with a NULL buffer
+// it only counts the bytes written
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+    MemoryStreamBuffer(u8* pBuffer, size_t size);
+    size_t GetUsedSize() const;
+
+protected:
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+    virtual int_type overflow(int_type c);
+    virtual std::streamsize xsgetn(char* s, std::streamsize n);
+    virtual int_type underflow();
+    virtual int_type uflow();
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+private:
+    u8* m_pBuffer;
+    size_t m_iSize;
+    size_t m_iPosition;
+    size_t m_iUsedSize;
+};
+
+inline MemoryStreamBuffer::MemoryStreamBuffer(u8* pBuffer, size_t size)
+{
+    m_pBuffer = pBuffer;
+    m_iSize = IsValidPointer(pBuffer) ? size : 0;
+    m_iPosition = 0;
+    m_iUsedSize = 0;
+}
+
+inline size_t MemoryStreamBuffer::GetUsedSize() const
+{
+    return m_iUsedSize;
+}
+
+inline std::streamsize MemoryStreamBuffer::xsputn(const char* s, std::streamsize n)
+{
+    if (IsValidPointer(m_pBuffer))
+    {
+        if ((n > 0) && (static_cast<size_t> (n) > (m_iSize - m_iPosition)))
+            return 0;
+
+        memcpy(m_pBuffer + m_iPosition, s, static_cast<size_t> (n));
+    }
+
+    m_iPosition += static_cast<size_t> (n);
+
+    if (m_iPosition > m_iUsedSize)
+        m_iUsedSize = m_iPosition;
+
+    return n;
+}
+
+inline MemoryStreamBuffer::int_type MemoryStreamBuffer::overflow(int_type c)
+{
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+
+    char value = traits_type::to_char_type(c);
+
+    return (xsputn(&value, 1) == 1) ? c : traits_type::eof();
+}
+
+inline std::streamsize MemoryStreamBuffer::xsgetn(char* s, std::streamsize n)
+{
+    size_t available = m_iSize - m_iPosition;
+    size_t count = (static_cast<size_t> (n) < available) ? static_cast<size_t> (n) : available;
+
+    if (count > 0)
+    {
+        memcpy(s, m_pBuffer + m_iPosition, count);
+        m_iPosition += count;
+    }
+
+    return static_cast<std::streamsize> (count);
+}
+
+inline MemoryStreamBuffer::int_type MemoryStreamBuffer::underflow()
+{
+    if (m_iPosition >= m_iSize)
+        return traits_type::eof();
+
+    return traits_type::to_int_type(static_cast<char> (m_pBuffer[m_iPosition]));
+}
+
+inline MemoryStreamBuffer::int_type MemoryStreamBuffer::uflow()
+{
+    int_type c = underflow();
+
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+        m_iPosition++;
+
+    return c;
+}
+
+inline MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode)
+{
+    off_type base = 0;
+
+    if (dir == std::ios_base::cur)
+        base = static_cast<off_type> (m_iPosition);
+    else if (dir == std::ios_base::end)
+        base = static_cast<off_type> (IsValidPointer(m_pBuffer) ? m_iSize : m_iUsedSize);
+
+    off_type position = base + off;
+
+    if ((position < 0) || (IsValidPointer(m_pBuffer) && (static_cast<size_t> (position) > m_iSize)))
+        return pos_type(off_type(-1));
+
+    m_iPosition = static_cast<size_t> (position);
+
+    return pos_type(position);
+}
+
+inline MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+#endif	/* MEMORYSTREAMBUFFER_H */
@@ -6,6 +6,11 @@
 
 inline u8 Memory::Read(u16 address)
 {
+    u8* pPage = m_pReadPages[address >> 12];
+
+    if (IsValidPointer(pPage))
+        return pPage[address & 0x0FFF];
+
     switch (address & 0xE000)
     {
         case 0x0000:
@@ -57,6 +62,14 @@ inline u8 Memory::Read(u16 address)
 
 inline void Memory::Write(u16 address, u8 value)
 {
+    u8* pPage = m_pWritePages[address >> 12];
+
+    if (IsValidPointer(pPage))
+    {
+        pPage[address & 0x0FFF] = value;
+        return;
+    }
+
     switch (address & 0xE000)
     {
         case 0x0000:
@@ -110,6 +123,8 @@ inline void Memory::SwitchCGBWRAM(u8 value)
 
     if (m_iCurrentWRAMBank == 0)
         m_iCurrentWRAMBank = 1;
+
+    m_pReadPages[0xD] = m_pWRAMBanks + (0x1000 * m_iCurrentWRAMBank);
 }
 
 inline u8 Memory::ReadCGBLCDRAM(u16 address, bool forceBank1)
@@ -131,6 +146,10 @@ inline void Memory::WriteCGBLCDRAM(u16 address, u8 value)
 inline void Memory::SwitchCGBLCDRAM(u8 value)
 {
     m_iCurrentLCDRAMBank = value;
+
+    u8* pVRAM = (m_iCurrentLCDRAMBank == 1) ? m_pLCDRAMBank1 : m_pMap + 0x8000;
+    m_pReadPages[0x8] = m_pWritePages[0x8] = pVRAM;
+    m_pReadPages[0x9] = m_pWritePages[0x9] = pVRAM + 0x1000;
 }
 
 inline u8 Memory::Retrieve(u16 address)
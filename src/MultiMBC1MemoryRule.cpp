@@ -99,6 +99,7 @@ void MultiMBC1MemoryRule::PerformWrite(u16 address, u8 value)
                 int rombank = ((m_iCurrentROMBank >> 1) & 0x30) | (m_iCurrentROMBank & 0xF);
                 m_iFinalROMBank = (rombank & 0x1F) ? rombank : (rombank | 1);
             }
+            UpdateMemoryMap();
             break;
         }
         case 0x4000:
@@ -118,6 +119,7 @@ void MultiMBC1MemoryRule::PerformWrite(u16 address, u8 value)
             if (m_bRamEnabled)
             {
                 m_pMemory->Load(address, value);
+                MarkRamDirty(address - 0xA000);
             }
             else
             {
@@ -157,6 +159,32 @@ void MultiMBC1MemoryRule::SetRomBank()
         m_iFinalROMBank0 = rombank & 0x30;
         m_iFinalROMBank = (rombank & 0x1F) ? rombank : (rombank | 1);
     }
+
+    UpdateMemoryMap();
 }
 
+void MultiMBC1MemoryRule::UpdateMemoryMap()
+{
+    u8* pROM = m_pCartridge->GetTheROM();
+    m_pMemory->MapROM(pROM + (0x4000 * m_iFinalROMBank0), pROM + (0x4000 * m_iFinalROMBank));
+}
 
+void MultiMBC1MemoryRule::SaveState(std::ostream& stream)
+{
+    stream.write(reinterpret_cast<const char*> (&m_iMode), sizeof(m_iMode));
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.write(reinterpret_cast<const char*> (&m_iFinalROMBank0), sizeof(m_iFinalROMBank0));
+    stream.write(reinterpret_cast<const char*> (&m_iFinalROMBank), sizeof(m_iFinalROMBank));
+    stream.write(reinterpret_cast<const char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+}
+
+void MultiMBC1MemoryRule::LoadState(std::istream& stream)
+{
+    stream.read(reinterpret_cast<char*> (&m_iMode), sizeof(m_iMode));
+    stream.read(reinterpret_cast<char*> (&m_iCurrentROMBank), sizeof(m_iCurrentROMBank));
+    stream.read(reinterpret_cast<char*> (&m_iFinalROMBank0), sizeof(m_iFinalROMBank0));
+    stream.read(reinterpret_cast<char*> (&m_iFinalROMBank), sizeof(m_iFinalROMBank));
+    stream.read(reinterpret_cast<char*> (&m_bRamEnabled), sizeof(m_bRamEnabled));
+
+    UpdateMemoryMap();
+}
@@ -138,8 +138,6 @@ u8 Processor::Tick()
     }
 
     UpdateDelayedInterrupts();
-    UpdateTimers();
-    UpdateSerial();
 
     if (m_iAccurateOPCodeState == 0 && m_iIMECycles > 0)
     {
@@ -394,9 +392,9 @@ void Processor::ServeInterrupt(Interrupts interrupt)
     }
 }
 
-void Processor::UpdateTimers()
+void Processor::UpdateTimers(unsigned int clockCycles)
 {
-    m_iDIVCycles += m_iCurrentClockCycles;
+    m_iDIVCycles += clockCycles;
 
     unsigned int div_cycles = AdjustedCycles(256);
 
@@ -413,7 +411,7 @@ void Processor::UpdateTimers()
     // if tima is running
     if (tac & 0x04)
     {
-        m_iTIMACycles += m_iCurrentClockCycles;
+        m_iTIMACycles += clockCycles;
 
         unsigned int freq = 0;
 
@@ -451,13 +449,13 @@ void Processor::UpdateTimers()
     }
 }
 
-void Processor::UpdateSerial()
+void Processor::UpdateSerial(unsigned int clockCycles)
 {
     u8 sc = m_pMemory->Retrieve(0xFF02);
 
     if (IsSetBit(sc, 7) && IsSetBit(sc, 0))
     {
-        m_iSerialCycles += m_iCurrentClockCycles;
+        m_iSerialCycles += clockCycles;
 
         if (m_iSerialBit < 0)
         {
@@ -490,6 +488,56 @@ void Processor::UpdateSerial()
     }
 }
 
+int Processor::GetNextEventCycles()
+{
+    // DIV is not an event, it is brought up to date before being read
+    int next = 0x7FFFFFFF;
+
+    if (m_bCGB && IsSetBit(m_pMemory->Retrieve(0xFF4D), 0))
+        return 0;
+
+    u8 tac = m_pMemory->Retrieve(0xFF07);
+
+    if (tac & 0x04)
+    {
+        int freq = 0;
+
+        switch (tac & 0x03)
+        {
+            case 0:
+                freq = AdjustedCycles(1024);
+                break;
+            case 1:
+                freq = AdjustedCycles(16);
+                break;
+            case 2:
+                freq = AdjustedCycles(64);
+                break;
+            case 3:
+                freq = AdjustedCycles(256);
+                break;
+        }
+
+        int tima = m_pMemory->Retrieve(0xFF05);
+        next = (freq * (0x100 - tima)) - static_cast<int>(m_iTIMACycles);
+    }
+
+    u8 sc = m_pMemory->Retrieve(0xFF02);
+
+    if (IsSetBit(sc, 7) && IsSetBit(sc, 0))
+    {
+        if (m_iSerialBit < 0)
+            return 0;
+
+        int serial = AdjustedCycles(512) - m_iSerialCycles;
+
+        if (serial < next)
+            next = serial;
+    }
+
+    return next;
+}
+
 void Processor::UpdateDelayedInterrupts()
 {
     for (int i = 0; i < 5; i++)
@@ -501,6 +549,74 @@ void Processor::UpdateDelayedInterrupts()
     }
 }
 
+void Processor::SaveState(std::ostream& stream)
+{
+    u16 af = AF.GetValue();
+    u16 bc = BC.GetValue();
+    u16 de = DE.GetValue();
+    u16 hl = HL.GetValue();
+    u16 sp = SP.GetValue();
+    u16 pc = PC.GetValue();
+
+    stream.write(reinterpret_cast<const char*> (&af), sizeof(af));
+    stream.write(reinterpret_cast<const char*> (&bc), sizeof(bc));
+    stream.write(reinterpret_cast<const char*> (&de), sizeof(de));
+    stream.write(reinterpret_cast<const char*> (&hl), sizeof(hl));
+    stream.write(reinterpret_cast<const char*> (&sp), sizeof(sp));
+    stream.write(reinterpret_cast<const char*> (&pc), sizeof(pc));
+    stream.write(reinterpret_cast<const char*> (&m_bIME), sizeof(m_bIME));
+    stream.write(reinterpret_cast<const char*> (&m_bHalt), sizeof(m_bHalt));
+    stream.write(reinterpret_cast<const char*> (&m_bBranchTaken), sizeof(m_bBranchTaken));
+    stream.write(reinterpret_cast<const char*> (&m_bSkipPCBug), sizeof(m_bSkipPCBug));
+    stream.write(reinterpret_cast<const char*> (&m_iCurrentClockCycles), sizeof(m_iCurrentClockCycles));
+    stream.write(reinterpret_cast<const char*> (&m_iDIVCycles), sizeof(m_iDIVCycles));
+    stream.write(reinterpret_cast<const char*> (&m_iTIMACycles), sizeof(m_iTIMACycles));
+    stream.write(reinterpret_cast<const char*> (&m_iSerialBit), sizeof(m_iSerialBit));
+    stream.write(reinterpret_cast<const char*> (&m_iSerialCycles), sizeof(m_iSerialCycles));
+    stream.write(reinterpret_cast<const char*> (&m_iIMECycles), sizeof(m_iIMECycles));
+    stream.write(reinterpret_cast<const char*> (&m_iUnhaltCycles), sizeof(m_iUnhaltCycles));
+    stream.write(reinterpret_cast<const char*> (m_InterruptDelayCycles), sizeof(m_InterruptDelayCycles));
+    stream.write(reinterpret_cast<const char*> (&m_bCGBSpeed), sizeof(m_bCGBSpeed));
+    stream.write(reinterpret_cast<const char*> (&m_iSpeedMultiplier), sizeof(m_iSpeedMultiplier));
+    stream.write(reinterpret_cast<const char*> (&m_iAccurateOPCodeState), sizeof(m_iAccurateOPCodeState));
+    stream.write(reinterpret_cast<const char*> (&m_iReadCache), sizeof(m_iReadCache));
+}
+
+void Processor::LoadState(std::istream& stream)
+{
+    u16 af, bc, de, hl, sp, pc;
+
+    stream.read(reinterpret_cast<char*> (&af), sizeof(af));
+    stream.read(reinterpret_cast<char*> (&bc), sizeof(bc));
+    stream.read(reinterpret_cast<char*> (&de), sizeof(de));
+    stream.read(reinterpret_cast<char*> (&hl), sizeof(hl));
+    stream.read(reinterpret_cast<char*> (&sp), sizeof(sp));
+    stream.read(reinterpret_cast<char*> (&pc), sizeof(pc));
+    stream.read(reinterpret_cast<char*> (&m_bIME), sizeof(m_bIME));
+    stream.read(reinterpret_cast<char*> (&m_bHalt), sizeof(m_bHalt));
+    stream.read(reinterpret_cast<char*> (&m_bBranchTaken), sizeof(m_bBranchTaken));
+    stream.read(reinterpret_cast<char*> (&m_bSkipPCBug), sizeof(m_bSkipPCBug));
+    stream.read(reinterpret_cast<char*> (&m_iCurrentClockCycles), sizeof(m_iCurrentClockCycles));
+    stream.read(reinterpret_cast<char*> (&m_iDIVCycles), sizeof(m_iDIVCycles));
+    stream.read(reinterpret_cast<char*> (&m_iTIMACycles), sizeof(m_iTIMACycles));
+    stream.read(reinterpret_cast<char*> (&m_iSerialBit), sizeof(m_iSerialBit));
+    stream.read(reinterpret_cast<char*> (&m_iSerialCycles), sizeof(m_iSerialCycles));
+    stream.read(reinterpret_cast<char*> (&m_iIMECycles), sizeof(m_iIMECycles));
+    stream.read(reinterpret_cast<char*> (&m_iUnhaltCycles), sizeof(m_iUnhaltCycles));
+    stream.read(reinterpret_cast<char*> (m_InterruptDelayCycles), sizeof(m_InterruptDelayCycles));
+    stream.read(reinterpret_cast<char*> (&m_bCGBSpeed), sizeof(m_bCGBSpeed));
+    stream.read(reinterpret_cast<char*> (&m_iSpeedMultiplier), sizeof(m_iSpeedMultiplier));
+    stream.read(reinterpret_cast<char*> (&m_iAccurateOPCodeState), sizeof(m_iAccurateOPCodeState));
+    stream.read(reinterpret_cast<char*> (&m_iReadCache), sizeof(m_iReadCache));
+
+    AF.SetValue(af);
+    BC.SetValue(bc);
+    DE.SetValue(de);
+    HL.SetValue(hl);
+    SP.SetValue(sp);
+    PC.SetValue(pc);
+}
+
 void Processor::InitOPCodeFunctors()
 {
     m_OPCodes[0x00] = &Processor::OPCode0x00;
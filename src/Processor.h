@@ -53,6 +53,11 @@ public:
     void AddCycles(unsigned int cycles);
     bool InterruptIsAboutToRaise();
     bool BootROMfinished() const;
+    void UpdateTimers(unsigned int clockCycles);
+    void UpdateSerial(unsigned int clockCycles);
+    int GetNextEventCycles();
+    void SaveState(std::ostream& stream);
+    void LoadState(std::istream& stream);
 
 private:
     typedef void (Processor::*OPCptr) (void);
@@ -90,8 +95,6 @@ private:
     void ExecuteOPCode(u8 opcode);
     Processor::Interrupts InterruptPending();
     void ServeInterrupt(Interrupts interrupt);
-    void UpdateTimers();
-    void UpdateSerial();
     void UpdateDelayedInterrupts();
     void ClearAllFlags();
     void ToggleZeroFlagFromResult(u8 result);
@@ -0,0 +1,234 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <sys/stat.h>
+#include "ROMCache.h"
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz/miniz.c"
+
+struct ROMCachePath
+{
+    std::string path;
+    long long fileSize;
+    time_t fileTime;
+    ROMImage* pImage;
+};
+
+static std::mutex s_Mutex;
+static std::vector<ROMImage*> s_Images;
+static std::vector<ROMCachePath> s_Paths;
+
+static bool GetFileInfo(const char* szFilePath, long long& fileSize, time_t& fileTime)
+{
+    struct stat info;
+
+    if (stat(szFilePath, &info) != 0)
+        return false;
+
+    fileSize = info.st_size;
+    fileTime = info.st_mtime;
+    return true;
+}
+
+ROMImage* ROMCache::Find(const char* szFilePath)
+{
+    long long fileSize;
+    time_t fileTime;
+
+    if (!GetFileInfo(szFilePath, fileSize, fileTime))
+        return NULL;
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+
+    for (std::size_t i = 0; i < s_Paths.size(); i++)
+    {
+        ROMCachePath& entry = s_Paths[i];
+
+        if ((entry.fileSize == fileSize) && (entry.fileTime == fileTime) && (entry.path == szFilePath))
+        {
+            entry.pImage->refCount++;
+            return entry.pImage;
+        }
+    }
+
+    return NULL;
+}
+
+ROMImage* ROMCache::LoadFile(const char* szFilePath)
+{
+    using namespace std;
+
+    ROMImage* pImage = Find(szFilePath);
+
+    if (IsValidPointer(pImage))
+        return pImage;
+
+    long long fileSize;
+    time_t fileTime;
+
+    if (!GetFileInfo(szFilePath, fileSize, fileTime) || (fileSize <= 0) || (fileSize > kROMImageMaxSize))
+    {
+        Log("There was a problem loading the file %s...", szFilePath);
+        return NULL;
+    }
+
+    int size = static_cast<int> (fileSize);
+    ifstream file(szFilePath, ios::in | ios::binary);
+
+    if (!file.is_open())
+    {
+        Log("There was a problem loading the file %s...", szFilePath);
+        return NULL;
+    }
+
+    u8* pData = Allocate(size);
+    file.read(reinterpret_cast<char*> (pData), size);
+
+    if (file.gcount() != size)
+    {
+        Log("There was a problem reading the file %s...", szFilePath);
+        SafeDeleteArray(pData);
+        return NULL;
+    }
+
+    pImage = new ROMImage;
+    pImage->pData = pData;
+    pImage->size = size;
+    pImage->hash = static_cast<u32> (mz_crc32(MZ_CRC32_INIT, pData, size));
+    pImage->refCount = 1;
+
+    return Add(pImage, szFilePath);
+}
+
+ROMImage* ROMCache::Insert(u8* pData, int size, const char* szFilePath)
+{
+    ROMImage* pImage = new ROMImage;
+    pImage->pData = pData;
+    pImage->size = size;
+    pImage->hash = static_cast<u32> (mz_crc32(MZ_CRC32_INIT, pData, size));
+    pImage->refCount = 1;
+
+    return Add(pImage, szFilePath);
+}
+
+void ROMCache::Release(ROMImage* pImage)
+{
+    if (!IsValidPointer(pImage))
+        return;
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+
+    pImage->refCount--;
+
+    if (pImage->refCount > 0)
+        return;
+
+    for (std::size_t i = 0; i < s_Paths.size();)
+    {
+        if (s_Paths[i].pImage == pImage)
+            s_Paths.erase(s_Paths.begin() + i);
+        else
+            i++;
+    }
+
+    for (std::size_t i = 0; i < s_Images.size(); i++)
+    {
+        if (s_Images[i] == pImage)
+        {
+            s_Images.erase(s_Images.begin() + i);
+            break;
+        }
+    }
+
+    Destroy(pImage);
+}
+
+u8* ROMCache::Allocate(int size)
+{
+    int banks = 2;
+
+    while ((banks * 0x4000) < size)
+        banks <<= 1;
+
+    int padded = banks * 0x4000;
+    u8* pData = new u8[padded];
+
+    // banks past the end of the image read as open bus
+    memset(pData + size, 0xFF, padded - size);
+
+    return pData;
+}
+
+ROMImage* ROMCache::Add(ROMImage* pImage, const char* szFilePath)
+{
+    long long fileSize = 0;
+    time_t fileTime = 0;
+    bool hasPath = IsValidPointer(szFilePath) && GetFileInfo(szFilePath, fileSize, fileTime);
+
+    bool shared = false;
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+
+    // identical contents loaded from elsewhere share the same image
+    for (std::size_t i = 0; i < s_Images.size(); i++)
+    {
+        ROMImage* pCached = s_Images[i];
+
+        if ((pCached->hash == pImage->hash) && (pCached->size == pImage->size) && (memcmp(pCached->pData, pImage->pData, pImage->size) == 0))
+        {
+            pCached->refCount++;
+            Destroy(pImage);
+            pImage = pCached;
+            shared = true;
+            break;
+        }
+    }
+
+    if (!shared)
+        s_Images.push_back(pImage);
+
+    if (hasPath)
+    {
+        for (std::size_t i = 0; i < s_Paths.size();)
+        {
+            if (s_Paths[i].path == szFilePath)
+                s_Paths.erase(s_Paths.begin() + i);
+            else
+                i++;
+        }
+
+        ROMCachePath entry;
+        entry.path = szFilePath;
+        entry.fileSize = fileSize;
+        entry.fileTime = fileTime;
+        entry.pImage = pImage;
+        s_Paths.push_back(entry);
+    }
+
+    return pImage;
+}
+
+void ROMCache::Destroy(ROMImage* pImage)
+{
+    SafeDeleteArray(pImage->pData);
+    SafeDelete(pImage);
+}
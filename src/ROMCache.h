@@ -0,0 +1,49 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef ROMCACHE_H
+#define	ROMCACHE_H
+
+#include "definitions.h"
+
+struct ROMImage
+{
+    u8* pData;
+    int size;
+    u32 hash;
+    int refCount;
+};
+
+class ROMCache
+{
+public:
+    static ROMImage* Find(const char* szFilePath);
+    static ROMImage* LoadFile(const char* szFilePath);
+    static ROMImage* Insert(u8* pData, int size, const char* szFilePath);
+    static void Release(ROMImage* pImage);
+    static u8* Allocate(int size);
+
+private:
+    static ROMImage* Add(ROMImage* pImage, const char* szFilePath);
+    static void Destroy(ROMImage* pImage);
+};
+
+const long long kROMImageMaxSize = 0x4000000;
+
+#endif	/* ROMCACHE_H */
@@ -0,0 +1,327 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include <map>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <sys/stat.h>
+#include "ROMScanner.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+static bool GetFileInfo(const char* szFilePath, long long& fileSize, long long& fileTime)
+{
+    struct stat info;
+
+    if (stat(szFilePath, &info) != 0)
+        return false;
+
+    fileSize = info.st_size;
+    fileTime = info.st_mtime;
+    return true;
+}
+
+struct ScanJob
+{
+    const std::vector<std::string>* pFiles;
+    std::vector<ROMInfo>* pResults;
+    std::vector<char>* pValid;
+    std::atomic<int> next;
+};
+
+static void ScanWorker(ScanJob* pJob)
+{
+    int count = static_cast<int> (pJob->pFiles->size());
+
+    for (int i = pJob->next++; i < count; i = pJob->next++)
+        (*pJob->pValid)[i] = ROMScanner::ReadInfo((*pJob->pFiles)[i].c_str(), (*pJob->pResults)[i]) ? 1 : 0;
+}
+
+static bool CompareInfo(const ROMInfo& a, const ROMInfo& b)
+{
+    return strcmp(a.szFilePath, b.szFilePath) < 0;
+}
+
+ROMScanner::ROMScanner()
+{
+}
+
+ROMScanner::~ROMScanner()
+{
+}
+
+bool ROMScanner::LoadIndex(const char* szIndexPath)
+{
+    using namespace std;
+
+    ifstream file(szIndexPath, ios::in | ios::binary);
+
+    if (!file.is_open())
+    {
+        Log("ROM index not found: %s", szIndexPath);
+        return false;
+    }
+
+    char signature[16];
+    u32 version = 0;
+    u32 entrySize = 0;
+    u32 count = 0;
+
+    file.read(signature, 16);
+    file.read(reinterpret_cast<char*> (&version), sizeof(version));
+    file.read(reinterpret_cast<char*> (&entrySize), sizeof(entrySize));
+    file.read(reinterpret_cast<char*> (&count), sizeof(count));
+
+    if (file.fail() || (strncmp(signature, ROM_INDEX_SIGNATURE, 16) != 0) || (version != ROM_INDEX_VERSION) || (entrySize != sizeof(ROMInfo)))
+    {
+        Log("Invalid ROM index: %s", szIndexPath);
+        return false;
+    }
+
+    vector<ROMInfo> entries(count);
+
+    if (count > 0)
+        file.read(reinterpret_cast<char*> (&entries[0]), count * sizeof(ROMInfo));
+
+    if (file.fail())
+    {
+        Log("Truncated ROM index: %s", szIndexPath);
+        return false;
+    }
+
+    for (u32 i = 0; i < count; i++)
+        entries[i].szFilePath[sizeof(entries[i].szFilePath) - 1] = 0;
+
+    m_Entries.swap(entries);
+    return true;
+}
+
+bool ROMScanner::SaveIndex(const char* szIndexPath) const
+{
+    using namespace std;
+
+    ofstream file(szIndexPath, ios::out | ios::binary | ios::trunc);
+
+    if (!file.is_open())
+    {
+        Log("Unable to write ROM index: %s", szIndexPath);
+        return false;
+    }
+
+    char signature[16];
+    u32 version = ROM_INDEX_VERSION;
+    u32 entrySize = sizeof(ROMInfo);
+    u32 count = static_cast<u32> (m_Entries.size());
+
+    memset(signature, 0, 16);
+    memcpy(signature, ROM_INDEX_SIGNATURE, 16);
+
+    file.write(signature, 16);
+    file.write(reinterpret_cast<const char*> (&version), sizeof(version));
+    file.write(reinterpret_cast<const char*> (&entrySize), sizeof(entrySize));
+    file.write(reinterpret_cast<const char*> (&count), sizeof(count));
+
+    if (count > 0)
+        file.write(reinterpret_cast<const char*> (&m_Entries[0]), count * sizeof(ROMInfo));
+
+    return !file.fail();
+}
+
+int ROMScanner::Scan(const char** szDirectories, int count, int threads)
+{
+    using namespace std;
+
+    vector<string> files;
+
+    for (int i = 0; i < count; i++)
+        ListDirectory(szDirectories[i], files);
+
+    sort(files.begin(), files.end());
+    files.erase(unique(files.begin(), files.end()), files.end());
+
+    map<string, int> indexed;
+
+    for (size_t i = 0; i < m_Entries.size(); i++)
+        indexed[m_Entries[i].szFilePath] = static_cast<int> (i);
+
+    vector<ROMInfo> entries;
+    vector<string> pending;
+
+    // unchanged files keep their indexed metadata
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        long long fileSize, fileTime;
+        map<string, int>::const_iterator it = indexed.find(files[i]);
+
+        if ((it != indexed.end()) && GetFileInfo(files[i].c_str(), fileSize, fileTime))
+        {
+            const ROMInfo& info = m_Entries[it->second];
+
+            if ((info.fileSize == fileSize) && (info.fileTime == fileTime))
+            {
+                entries.push_back(info);
+                continue;
+            }
+        }
+
+        pending.push_back(files[i]);
+    }
+
+    int pendingCount = static_cast<int> (pending.size());
+    vector<ROMInfo> results(pendingCount);
+    vector<char> valid(pendingCount, 0);
+
+    ScanJob job;
+    job.pFiles = &pending;
+    job.pResults = &results;
+    job.pValid = &valid;
+    job.next = 0;
+
+    threads = std::max(1, std::min(threads, pendingCount));
+
+    vector<thread> workers;
+
+    for (int t = 0; t < threads; t++)
+        workers.push_back(thread(ScanWorker, &job));
+
+    for (size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+
+    for (int i = 0; i < pendingCount; i++)
+    {
+        if (valid[i])
+            entries.push_back(results[i]);
+    }
+
+    sort(entries.begin(), entries.end(), CompareInfo);
+    m_Entries.swap(entries);
+
+    return pendingCount;
+}
+
+int ROMScanner::GetCount() const
+{
+    return static_cast<int> (m_Entries.size());
+}
+
+const ROMInfo* ROMScanner::GetInfo(int index) const
+{
+    if ((index < 0) || (index >= GetCount()))
+        return NULL;
+
+    return &m_Entries[index];
+}
+
+bool ROMScanner::ReadInfo(const char* szFilePath, ROMInfo& info)
+{
+    memset(&info, 0, sizeof(info));
+
+    if ((strlen(szFilePath) >= sizeof(info.szFilePath)) || !GetFileInfo(szFilePath, info.fileSize, info.fileTime))
+        return false;
+
+    Cartridge cartridge;
+
+    if (!cartridge.LoadHeaderFromFile(szFilePath))
+        return false;
+
+    strcpy(info.szFilePath, szFilePath);
+    strncpy(info.szName, cartridge.GetName(), sizeof(info.szName) - 1);
+    info.type = cartridge.GetType();
+    info.romSize = cartridge.GetROMSize();
+    info.ramSize = cartridge.GetRAMSize();
+    info.romBankCount = cartridge.GetROMBankCount();
+    info.ramBankCount = cartridge.GetRAMBankCount();
+    info.totalSize = cartridge.GetTotalSize();
+    info.version = cartridge.GetVersion();
+    info.cgb = cartridge.IsCGB();
+    info.sgb = cartridge.IsSGB();
+    info.battery = cartridge.HasBattery();
+    info.rtc = cartridge.IsRTCPresent();
+    info.rumble = cartridge.IsRumblePresent();
+    info.validChecksum = cartridge.IsValidROM();
+
+    return true;
+}
+
+void ROMScanner::ListDirectory(const std::string& directory, std::vector<std::string>& files)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE hFind = FindFirstFileA((directory + "\\*").c_str(), &data);
+
+    if (hFind == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        std::string name(data.cFileName);
+
+        if ((name == ".") || (name == ".."))
+            continue;
+
+        std::string path = directory + "\\" + name;
+
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            ListDirectory(path, files);
+        else if (Cartridge::IsROMExtension(name.c_str()) || Cartridge::IsZipExtension(name.c_str()))
+            files.push_back(path);
+    }
+    while (FindNextFileA(hFind, &data));
+
+    FindClose(hFind);
+#else
+    DIR* pDir = opendir(directory.c_str());
+
+    if (!IsValidPointer(pDir))
+        return;
+
+    struct dirent* pEntry;
+
+    while (IsValidPointer(pEntry = readdir(pDir)))
+    {
+        std::string name(pEntry->d_name);
+
+        if ((name == ".") || (name == ".."))
+            continue;
+
+        std::string path = directory + "/" + name;
+        struct stat info;
+
+        if (lstat(path.c_str(), &info) != 0)
+            continue;
+
+        // symlinks are followed to files only, so links cannot loop
+        if (S_ISLNK(info.st_mode) && ((stat(path.c_str(), &info) != 0) || S_ISDIR(info.st_mode)))
+            continue;
+
+        if (S_ISDIR(info.st_mode))
+            ListDirectory(path, files);
+        else if (Cartridge::IsROMExtension(name.c_str()) || Cartridge::IsZipExtension(name.c_str()))
+            files.push_back(path);
+    }
+
+    closedir(pDir);
+#endif
+}
@@ -0,0 +1,67 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef ROMSCANNER_H
+#define	ROMSCANNER_H
+
+#include <string>
+#include <vector>
+#include "Cartridge.h"
+
+struct ROMInfo
+{
+    char szFilePath[512];
+    long long fileSize;
+    long long fileTime;
+    char szName[16];
+    Cartridge::CartridgeTypes type;
+    int romSize;
+    int ramSize;
+    int romBankCount;
+    int ramBankCount;
+    int totalSize;
+    int version;
+    bool cgb;
+    bool sgb;
+    bool battery;
+    bool rtc;
+    bool rumble;
+    bool validChecksum;
+};
+
+class ROMScanner
+{
+public:
+    ROMScanner();
+    ~ROMScanner();
+    bool LoadIndex(const char* szIndexPath);
+    bool SaveIndex(const char* szIndexPath) const;
+    int Scan(const char** szDirectories, int count, int threads);
+    int GetCount() const;
+    const ROMInfo* GetInfo(int index) const;
+    static bool ReadInfo(const char* szFilePath, ROMInfo& info);
+
+private:
+    void ListDirectory(const std::string& directory, std::vector<std::string>& files);
+
+private:
+    std::vector<ROMInfo> m_Entries;
+};
+
+#endif	/* ROMSCANNER_H */
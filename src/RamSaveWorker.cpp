@@ -0,0 +1,487 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include <stdio.h>
+#include <algorithm>
+#include "RamSaveWorker.h"
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz/miniz.c"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RAMSAVE_FSYNC 1
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#endif
+
+RamSaveWorker::RamSaveWorker()
+{
+    m_bPending = false;
+    m_bWriting = false;
+    m_bPendingFull = false;
+    m_bWritingFull = false;
+    m_bFlush = false;
+    m_bFailed = false;
+    m_bQuit = false;
+    m_bStarted = false;
+}
+
+RamSaveWorker::~RamSaveWorker()
+{
+    if (m_bStarted)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_bQuit = true;
+        }
+
+        m_Condition.notify_one();
+        m_Thread.join();
+    }
+}
+
+void RamSaveWorker::Submit(const char* szPath, const u8* pData, int size, const u8* pDirtyPages)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if (!m_bStarted)
+    {
+        m_Thread = std::thread(&RamSaveWorker::Run, this);
+        m_bStarted = true;
+    }
+
+    // a snapshot for another file is written first, it is only dropped
+    // when that write fails
+    if (m_bPending && (m_PendingPath != szPath))
+        m_bFailed = false;
+
+    while (m_bPending && (m_PendingPath != szPath))
+    {
+        if (m_bFailed)
+        {
+            Log("Save file not written, changes dropped: %s", m_PendingPath.c_str());
+            m_bPending = false;
+            break;
+        }
+
+        m_bFlush = true;
+        m_Condition.notify_one();
+        m_Done.wait(lock);
+    }
+
+    Clock::time_point now = Clock::now();
+
+    if (!m_bPending)
+    {
+        m_FirstSubmit = now;
+        m_bPendingFull = false;
+        m_PendingDirty.assign(kRamDirtyPageCount, 0);
+    }
+
+    // pages dirtied by earlier snapshots still have to reach the file
+    if (IsValidPointer(pDirtyPages))
+    {
+        for (int i = 0; i < kRamDirtyPageCount; i++)
+            m_PendingDirty[i] |= pDirtyPages[i];
+    }
+    else
+        m_bPendingFull = true;
+
+    // newer snapshots replace the pending one and push the deadline back,
+    // up to the maximum delay since the first unsaved change
+    m_PendingPath = szPath;
+    m_Pending.assign(pData, pData + size);
+    m_LastSubmit = now;
+    m_bPending = true;
+
+    m_Condition.notify_one();
+}
+
+bool RamSaveWorker::Flush()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if (!m_bStarted)
+        return true;
+
+    m_bFailed = false;
+    m_bFlush = true;
+    m_Condition.notify_one();
+
+    // a failed snapshot stays pending, the flush gives up after one attempt
+    while (m_bWriting || (m_bPending && !m_bFailed))
+        m_Done.wait(lock);
+
+    return !m_bFailed;
+}
+
+void RamSaveWorker::Run()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    while (true)
+    {
+        if (m_bPending)
+        {
+            Clock::time_point deadline = std::min(m_LastSubmit + std::chrono::milliseconds(kRamSaveDebounceMs), m_FirstSubmit + std::chrono::milliseconds(kRamSaveMaxDelayMs));
+
+            if (!m_bFlush && !m_bQuit && (Clock::now() < deadline))
+            {
+                m_Condition.wait_until(lock, deadline);
+                continue;
+            }
+
+            m_Writing.swap(m_Pending);
+            m_WritingPath.swap(m_PendingPath);
+            m_WritingDirty.swap(m_PendingDirty);
+            m_bWritingFull = m_bPendingFull;
+            m_bPending = false;
+            m_bWriting = true;
+
+            lock.unlock();
+            bool ok = (!m_bWritingFull && Patch(m_WritingPath, m_Writing, m_WritingDirty)) || Write(m_WritingPath, m_Writing);
+            lock.lock();
+
+            m_bWriting = false;
+
+            if (!ok)
+                Retry();
+
+            m_Done.notify_all();
+            continue;
+        }
+
+        m_bFlush = false;
+
+        if (m_bQuit)
+            break;
+
+        m_Condition.wait(lock);
+    }
+}
+
+// called with the lock held after a failed write, the snapshot is kept and
+// written in full later, or replaced by a newer one for the same file
+void RamSaveWorker::Retry()
+{
+    m_bFailed = true;
+    m_bFlush = false;
+
+    if (m_bQuit)
+    {
+        Log("Save file not written, changes dropped: %s", m_WritingPath.c_str());
+        m_bPending = false;
+        return;
+    }
+
+    if (m_bPending)
+    {
+        if (m_PendingPath == m_WritingPath)
+        {
+            m_bPendingFull = true;
+        }
+        else
+        {
+            Log("Save file not written, changes dropped: %s", m_WritingPath.c_str());
+        }
+
+        return;
+    }
+
+    m_Pending.swap(m_Writing);
+    m_PendingPath.swap(m_WritingPath);
+    m_bPendingFull = true;
+    m_bPending = true;
+
+    // failed saves are retried after the maximum delay, or sooner if the
+    // RAM changes again
+    m_FirstSubmit = Clock::now();
+    m_LastSubmit = m_FirstSubmit + std::chrono::milliseconds(kRamSaveMaxDelayMs);
+}
+
+// the dirty pages are logged to a journal before they are written in place,
+// a patch interrupted midway is completed from it by Recover, so the save
+// file always holds either the old or the new contents
+bool RamSaveWorker::Patch(const std::string& path, const std::vector<u8>& data, const std::vector<u8>& dirtyPages)
+{
+    if (!Recover(path.c_str()))
+        return false;
+
+    FILE* file = fopen(path.c_str(), "r+b");
+
+    if (!IsValidPointer(file))
+        return false;
+
+    // only a save file with the same layout can be patched in place
+    if ((fseek(file, 0, SEEK_END) != 0) || (ftell(file) != static_cast<long> (data.size())))
+    {
+        fclose(file);
+        return false;
+    }
+
+    const int pageSize = 1 << kRamDirtyPageShift;
+    int size = static_cast<int> (data.size());
+    int pages = (size + pageSize - 1) / pageSize;
+    std::vector<u8> journal;
+
+    AppendJournalValue(journal, static_cast<u32> (size));
+
+    for (int i = 0; i < pages; i++)
+    {
+        if ((i < kRamDirtyPageCount) && !dirtyPages[i])
+            continue;
+
+        int offset = i * pageSize;
+        int count = std::min(pageSize, size - offset);
+
+        AppendJournalValue(journal, static_cast<u32> (offset));
+        AppendJournalValue(journal, static_cast<u32> (count));
+        journal.insert(journal.end(), data.begin() + offset, data.begin() + offset + count);
+    }
+
+    AppendJournalValue(journal, static_cast<u32> (mz_crc32(MZ_CRC32_INIT, &journal[0], journal.size())));
+
+    std::string journalPath = path + ".journal";
+
+    if (!WriteFile(journalPath, journal))
+    {
+        fclose(file);
+        remove(journalPath.c_str());
+        return false;
+    }
+
+    // the journal has to be reachable before the save file is touched
+    SyncDirectory(path);
+
+    bool ok = ApplyJournal(file, journal);
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok)
+    {
+        // left for Recover, the full write that follows replays it first
+        Log("Unable to update save file: %s", path.c_str());
+        return false;
+    }
+
+    remove(journalPath.c_str());
+
+    return true;
+}
+
+bool RamSaveWorker::Write(const std::string& path, const std::vector<u8>& data)
+{
+    std::string temp = path + ".tmp";
+
+    if (!WriteFile(temp, data))
+    {
+        Log("Unable to write save file: %s", temp.c_str());
+        remove(temp.c_str());
+        return false;
+    }
+
+    // a journal left by an interrupted patch must not be replayed over
+    // the new contents
+    if (!Recover(path.c_str()))
+        remove((path + ".journal").c_str());
+
+    // the previous save stays intact until the new one is complete
+#if defined(_WIN32)
+    bool ok = (MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+#if !defined(RAMSAVE_FSYNC)
+    remove(path.c_str());
+#endif
+    bool ok = (rename(temp.c_str(), path.c_str()) == 0);
+#endif
+
+    if (!ok)
+    {
+        Log("Unable to replace save file: %s", path.c_str());
+        remove(temp.c_str());
+        return false;
+    }
+
+    SyncDirectory(path);
+
+    return true;
+}
+
+// completes a patch interrupted by a crash or power loss, a journal that
+// was not fully written is dropped, the save file was not touched yet
+bool RamSaveWorker::Recover(const char* szPath)
+{
+    std::string journalPath = std::string(szPath) + ".journal";
+    FILE* file = fopen(journalPath.c_str(), "rb");
+
+    if (!IsValidPointer(file))
+        return true;
+
+    std::vector<u8> journal;
+    long size = ((fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1);
+
+    if ((size > 0) && (fseek(file, 0, SEEK_SET) == 0))
+    {
+        journal.resize(size);
+
+        if (fread(&journal[0], 1, size, file) != static_cast<size_t> (size))
+            journal.clear();
+    }
+
+    fclose(file);
+
+    if (!IsValidJournal(journal))
+    {
+        Log("Discarding incomplete save journal: %s", journalPath.c_str());
+        remove(journalPath.c_str());
+        return true;
+    }
+
+    file = fopen(szPath, "r+b");
+
+    bool ok = IsValidPointer(file);
+
+    if (ok)
+    {
+        ok = (fseek(file, 0, SEEK_END) == 0) && (ftell(file) == static_cast<long> (ReadJournalValue(journal, 0)));
+        ok = ok && ApplyJournal(file, journal);
+        ok = (fclose(file) == 0) && ok;
+    }
+
+    if (!ok)
+    {
+        Log("Unable to recover save file: %s", szPath);
+        return false;
+    }
+
+    Log("Save file recovered from journal: %s", szPath);
+    remove(journalPath.c_str());
+
+    return true;
+}
+
+bool RamSaveWorker::WriteFile(const std::string& path, const std::vector<u8>& data)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+
+    if (!IsValidPointer(file))
+        return false;
+
+    bool ok = data.empty() || (fwrite(&data[0], 1, data.size(), file) == data.size());
+    ok = ok && SyncFile(file);
+
+    return (fclose(file) == 0) && ok;
+}
+
+bool RamSaveWorker::SyncFile(FILE* file)
+{
+    bool ok = (fflush(file) == 0);
+
+#if defined(RAMSAVE_FSYNC)
+    ok = ok && (fsync(fileno(file)) == 0);
+#elif defined(_WIN32)
+    ok = ok && (_commit(_fileno(file)) == 0);
+#endif
+
+    return ok;
+}
+
+void RamSaveWorker::SyncDirectory(const std::string& path)
+{
+#if defined(RAMSAVE_FSYNC)
+    size_t slash = path.find_last_of('/');
+    std::string directory = (slash == std::string::npos) ? std::string(".") : path.substr(0, slash + 1);
+    int fd = open(directory.c_str(), O_RDONLY);
+
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+// journal layout: save file size, then offset, length and data of every
+// page, then the CRC32 of everything before it
+bool RamSaveWorker::IsValidJournal(const std::vector<u8>& journal)
+{
+    size_t size = journal.size();
+
+    if (size < 8)
+        return false;
+
+    if (ReadJournalValue(journal, size - 4) != static_cast<u32> (mz_crc32(MZ_CRC32_INIT, &journal[0], size - 4)))
+        return false;
+
+    size_t position = 4;
+
+    while (position < size - 4)
+    {
+        if (position + 8 > size - 4)
+            return false;
+
+        u32 offset = ReadJournalValue(journal, position);
+        u32 count = ReadJournalValue(journal, position + 4);
+        position += 8;
+
+        if ((count > size - 4 - position) || (offset + count > ReadJournalValue(journal, 0)))
+            return false;
+
+        position += count;
+    }
+
+    return true;
+}
+
+bool RamSaveWorker::ApplyJournal(FILE* file, const std::vector<u8>& journal)
+{
+    size_t end = journal.size() - 4;
+    size_t position = 4;
+    bool ok = true;
+
+    while (ok && (position < end))
+    {
+        u32 offset = ReadJournalValue(journal, position);
+        u32 count = ReadJournalValue(journal, position + 4);
+        position += 8;
+
+        ok = (fseek(file, offset, SEEK_SET) == 0) && (fwrite(&journal[position], 1, count, file) == count);
+        position += count;
+    }
+
+    return ok && SyncFile(file);
+}
+
+void RamSaveWorker::AppendJournalValue(std::vector<u8>& journal, u32 value)
+{
+    for (int i = 0; i < 4; i++)
+        journal.push_back((value >> (i * 8)) & 0xFF);
+}
+
+u32 RamSaveWorker::ReadJournalValue(const std::vector<u8>& journal, size_t position)
+{
+    u32 value = 0;
+
+    for (int i = 0; i < 4; i++)
+        value |= journal[position + i] << (i * 8);
+
+    return value;
+}
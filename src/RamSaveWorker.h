@@ -0,0 +1,82 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef RAMSAVEWORKER_H
+#define	RAMSAVEWORKER_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "definitions.h"
+#include "MemoryRule.h"
+
+class RamSaveWorker
+{
+public:
+    RamSaveWorker();
+    ~RamSaveWorker();
+    void Submit(const char* szPath, const u8* pData, int size, const u8* pDirtyPages = NULL);
+    bool Flush();
+    static bool Recover(const char* szPath);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void Run();
+    void Retry();
+    static bool Write(const std::string& path, const std::vector<u8>& data);
+    static bool Patch(const std::string& path, const std::vector<u8>& data, const std::vector<u8>& dirtyPages);
+    static bool WriteFile(const std::string& path, const std::vector<u8>& data);
+    static bool SyncFile(FILE* file);
+    static void SyncDirectory(const std::string& path);
+    static bool IsValidJournal(const std::vector<u8>& journal);
+    static bool ApplyJournal(FILE* file, const std::vector<u8>& journal);
+    static void AppendJournalValue(std::vector<u8>& journal, u32 value);
+    static u32 ReadJournalValue(const std::vector<u8>& journal, size_t position);
+
+private:
+    std::thread m_Thread;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::condition_variable m_Done;
+    std::string m_PendingPath;
+    std::vector<u8> m_Pending;
+    std::vector<u8> m_PendingDirty;
+    std::string m_WritingPath;
+    std::vector<u8> m_Writing;
+    std::vector<u8> m_WritingDirty;
+    bool m_bPendingFull;
+    bool m_bWritingFull;
+    bool m_bPending;
+    bool m_bWriting;
+    bool m_bFlush;
+    bool m_bFailed;
+    bool m_bQuit;
+    bool m_bStarted;
+    Clock::time_point m_FirstSubmit;
+    Clock::time_point m_LastSubmit;
+};
+
+const int kRamSaveDebounceMs = 500;
+const int kRamSaveMaxDelayMs = 5000;
+
+#endif	/* RAMSAVEWORKER_H */
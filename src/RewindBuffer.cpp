@@ -0,0 +1,438 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include "RewindBuffer.h"
+#include "GearboyCore.h"
+
+RewindBuffer::RewindBuffer(GearboyCore* pCore)
+{
+    m_pCore = pCore;
+    InitPointer(m_pCompressor);
+    InitPointer(m_pBuffer);
+    InitPointer(m_pEntries);
+    InitPointer(m_pCurrent);
+    InitPointer(m_pNext);
+    InitPointer(m_pWork);
+    InitPointer(m_pCompressed);
+    InitPointer(m_pEncoded);
+    m_iCompressionFlags = tdefl_create_comp_flags_from_zip_params(MZ_BEST_SPEED, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY) | TDEFL_NONDETERMINISTIC_PARSING_FLAG;
+    m_bEnabled = false;
+    m_iStateSize = 0;
+    m_iEncodedSize = 0;
+    m_iBufferSize = kRewindDefaultBufferSize;
+    m_iMaxSnapshots = kRewindDefaultMaxSnapshots;
+    m_iFrameInterval = kRewindDefaultFrameInterval;
+    m_iKeyframeInterval = kRewindDefaultKeyframeInterval;
+    Reset();
+}
+
+RewindBuffer::~RewindBuffer()
+{
+    Release();
+}
+
+void RewindBuffer::Reset()
+{
+    m_bCurrentValid = false;
+    m_bSkipFrame = false;
+    m_iWritePosition = 0;
+    m_iFirstEntry = 0;
+    m_iEntryCount = 0;
+    m_iFrameCounter = 0;
+    m_iSnapshotCounter = 0;
+}
+
+void RewindBuffer::Enable(bool enabled)
+{
+    if (enabled == m_bEnabled)
+        return;
+
+    m_bEnabled = enabled;
+
+    if (m_bEnabled)
+        Allocate();
+    else
+        Release();
+}
+
+void RewindBuffer::SetParameters(int bufferSize, int maxSnapshots, int frameInterval, int keyframeInterval)
+{
+    m_iBufferSize = (bufferSize > 0) ? bufferSize : kRewindDefaultBufferSize;
+    m_iMaxSnapshots = (maxSnapshots > 0) ? maxSnapshots : kRewindDefaultMaxSnapshots;
+    m_iFrameInterval = (frameInterval > 0) ? frameInterval : kRewindDefaultFrameInterval;
+    m_iKeyframeInterval = (keyframeInterval > 0) ? keyframeInterval : kRewindDefaultKeyframeInterval;
+
+    if (m_bEnabled)
+    {
+        Release();
+        Allocate();
+    }
+}
+
+void RewindBuffer::Frame()
+{
+    if (!m_bEnabled)
+        return;
+
+    if (m_bSkipFrame)
+    {
+        m_bSkipFrame = false;
+        return;
+    }
+
+    m_iFrameCounter++;
+
+    if (m_iFrameCounter < m_iFrameInterval)
+        return;
+
+    m_iFrameCounter = 0;
+
+    PushSnapshot();
+}
+
+bool RewindBuffer::StepBack(int snapshots)
+{
+    if (!m_bEnabled || !m_bCurrentValid || (m_iEntryCount == 0) || (snapshots <= 0))
+        return false;
+
+    if (snapshots > m_iEntryCount)
+        snapshots = m_iEntryCount;
+
+    int target = m_iEntryCount - snapshots;
+    int start = m_iEntryCount;
+
+    // the nearest keyframe above the target saves walking the deltas
+    // all the way down from the newest snapshot
+    for (int i = target; i < m_iEntryCount; i++)
+    {
+        if (GetEntry(i)->keyframe)
+        {
+            start = i;
+            break;
+        }
+    }
+
+    if (start == m_iEntryCount)
+        memcpy(m_pWork, m_pCurrent, m_iStateSize);
+    else if (!ExtractEntry(start, m_pWork))
+    {
+        Log("Rewind: corrupted snapshot");
+        Reset();
+        return false;
+    }
+
+    for (int i = start - 1; i >= target; i--)
+    {
+        if (!ExtractEntry(i, m_pWork))
+        {
+            Log("Rewind: corrupted snapshot");
+            Reset();
+            return false;
+        }
+    }
+
+    if (!m_pCore->LoadStateFromBuffer(m_pWork, m_iStateSize))
+        return false;
+
+    u8* pTemp = m_pCurrent;
+    m_pCurrent = m_pWork;
+    m_pWork = pTemp;
+
+    m_iWritePosition = GetEntry(target)->offset;
+    m_iEntryCount = target;
+    m_iFrameCounter = 0;
+    m_bSkipFrame = true;
+
+    return true;
+}
+
+void RewindBuffer::Allocate()
+{
+    m_pCompressor = new tdefl_compressor;
+    m_pBuffer = new u8[m_iBufferSize];
+    m_pEntries = new RewindEntry[m_iMaxSnapshots];
+    m_iStateSize = 0;
+    Reset();
+}
+
+void RewindBuffer::Release()
+{
+    SafeDelete(m_pCompressor);
+    SafeDeleteArray(m_pBuffer);
+    SafeDeleteArray(m_pEntries);
+    SafeDeleteArray(m_pCurrent);
+    SafeDeleteArray(m_pNext);
+    SafeDeleteArray(m_pWork);
+    SafeDeleteArray(m_pEncoded);
+    SafeDeleteArray(m_pCompressed);
+    m_iStateSize = 0;
+    m_iEncodedSize = 0;
+    Reset();
+}
+
+bool RewindBuffer::AllocateStateBuffers(size_t stateSize)
+{
+    SafeDeleteArray(m_pCurrent);
+    SafeDeleteArray(m_pNext);
+    SafeDeleteArray(m_pWork);
+    SafeDeleteArray(m_pEncoded);
+    SafeDeleteArray(m_pCompressed);
+
+    m_iStateSize = stateSize;
+    m_iEncodedSize = stateSize + 16;
+    Reset();
+
+    if (m_iStateSize == 0)
+        return false;
+
+    m_pCurrent = new u8[m_iStateSize];
+    m_pNext = new u8[m_iStateSize];
+    m_pWork = new u8[m_iStateSize];
+    m_pEncoded = new u8[m_iEncodedSize];
+    m_pCompressed = new u8[m_iEncodedSize];
+
+    return true;
+}
+
+void RewindBuffer::PushSnapshot()
+{
+    if ((m_iStateSize == 0) || !m_pCore->SaveStateToBuffer(m_pNext, m_iStateSize))
+    {
+        // first snapshot or the state layout changed (new ROM, DMG/CGB switch)
+        size_t stateSize = m_pCore->GetStateSize();
+
+        if ((stateSize != m_iStateSize) && !AllocateStateBuffers(stateSize))
+            return;
+
+        if (!m_pCore->SaveStateToBuffer(m_pNext, m_iStateSize))
+            return;
+    }
+
+    if (m_bCurrentValid)
+    {
+        bool keyframe = (m_iSnapshotCounter % m_iKeyframeInterval) == 0;
+        m_iSnapshotCounter++;
+
+        // deltas are backwards: previous = next ^ delta
+        size_t size = EncodeRuns(m_pCurrent, keyframe ? NULL : m_pNext);
+        StoreEntry(size, keyframe);
+    }
+
+    u8* pTemp = m_pCurrent;
+    m_pCurrent = m_pNext;
+    m_pNext = pTemp;
+    m_bCurrentValid = true;
+}
+
+void RewindBuffer::StoreEntry(size_t size, bool keyframe)
+{
+    const u8* pPayload = m_pEncoded;
+    size_t inSize = size;
+    size_t outSize = m_iEncodedSize;
+    bool compressed = false;
+
+    tdefl_init(m_pCompressor, NULL, NULL, m_iCompressionFlags);
+
+    if ((tdefl_compress(m_pCompressor, m_pEncoded, &inSize, m_pCompressed, &outSize, TDEFL_FINISH) == TDEFL_STATUS_DONE) && (outSize < size))
+    {
+        pPayload = m_pCompressed;
+        size = outSize;
+        compressed = true;
+    }
+
+    if (size > m_iBufferSize)
+    {
+        // the history can't be kept contiguous, start over from here
+        m_iWritePosition = 0;
+        m_iFirstEntry = 0;
+        m_iEntryCount = 0;
+        return;
+    }
+
+    size_t offset = m_iWritePosition;
+
+    if ((offset + size) > m_iBufferSize)
+    {
+        offset = 0;
+
+        // drop the oldest entries left at the end of the buffer
+        while ((m_iEntryCount > 0) && (GetEntry(0)->offset >= m_iWritePosition))
+        {
+            m_iFirstEntry = (m_iFirstEntry + 1) % m_iMaxSnapshots;
+            m_iEntryCount--;
+        }
+    }
+
+    while (m_iEntryCount > 0)
+    {
+        RewindEntry* pOldest = GetEntry(0);
+        bool overlap = (pOldest->offset < (offset + size)) && (offset < (pOldest->offset + pOldest->size));
+
+        if (!overlap && (m_iEntryCount < m_iMaxSnapshots))
+            break;
+
+        m_iFirstEntry = (m_iFirstEntry + 1) % m_iMaxSnapshots;
+        m_iEntryCount--;
+    }
+
+    if (m_iEntryCount == 0)
+        m_iFirstEntry = 0;
+
+    RewindEntry* pEntry = GetEntry(m_iEntryCount);
+    pEntry->offset = offset;
+    pEntry->size = size;
+    pEntry->keyframe = keyframe;
+    pEntry->compressed = compressed;
+
+    memcpy(m_pBuffer + offset, pPayload, size);
+
+    m_iEntryCount++;
+    m_iWritePosition = offset + size;
+}
+
+bool RewindBuffer::ExtractEntry(int entry, u8* pOut)
+{
+    RewindEntry* pEntry = GetEntry(entry);
+    const u8* pIn = m_pBuffer + pEntry->offset;
+    size_t size = pEntry->size;
+
+    if (pEntry->compressed)
+    {
+        size = tinfl_decompress_mem_to_mem(m_pEncoded, m_iEncodedSize, pIn, size, 0);
+
+        if (size == TINFL_DECOMPRESS_MEM_TO_MEM_FAILED)
+            return false;
+
+        pIn = m_pEncoded;
+    }
+
+    return DecodeRuns(pIn, size, pOut, !pEntry->keyframe);
+}
+
+// snapshots are mostly unchanged (deltas) or zero filled (keyframes) so
+// they are stored as runs of zero words followed by runs of literal words
+// before deflating, which keeps the compressor off the empty areas
+size_t RewindBuffer::EncodeRuns(const u8* pData, const u8* pBase)
+{
+    size_t words = m_iStateSize >> 3;
+    size_t i = 0;
+    u8* pOut = m_pEncoded;
+
+    while (i < words)
+    {
+        u64 word = 0;
+        u32 zeros = 0;
+        u32 literals = 0;
+
+        while (i < words)
+        {
+            memcpy(&word, pData + (i << 3), 8);
+            if (IsValidPointer(pBase))
+            {
+                u64 base;
+                memcpy(&base, pBase + (i << 3), 8);
+                word ^= base;
+            }
+            if (word != 0)
+                break;
+            zeros++;
+            i++;
+        }
+
+        u8* pHeader = pOut;
+        pOut += 8;
+
+        while (i < words)
+        {
+            memcpy(&word, pData + (i << 3), 8);
+            if (IsValidPointer(pBase))
+            {
+                u64 base;
+                memcpy(&base, pBase + (i << 3), 8);
+                word ^= base;
+            }
+            if (word == 0)
+                break;
+            memcpy(pOut, &word, 8);
+            pOut += 8;
+            literals++;
+            i++;
+        }
+
+        memcpy(pHeader, &zeros, 4);
+        memcpy(pHeader + 4, &literals, 4);
+    }
+
+    for (size_t j = words << 3; j < m_iStateSize; j++)
+        *pOut++ = IsValidPointer(pBase) ? (pData[j] ^ pBase[j]) : pData[j];
+
+    return pOut - m_pEncoded;
+}
+
+bool RewindBuffer::DecodeRuns(const u8* pIn, size_t size, u8* pOut, bool delta)
+{
+    size_t words = m_iStateSize >> 3;
+    size_t tail = m_iStateSize - (words << 3);
+    size_t i = 0;
+    const u8* pEnd = pIn + size;
+
+    while (i < words)
+    {
+        u32 zeros;
+        u32 literals;
+
+        if ((pEnd - pIn) < 8)
+            return false;
+
+        memcpy(&zeros, pIn, 4);
+        memcpy(&literals, pIn + 4, 4);
+        pIn += 8;
+
+        size_t count = static_cast<size_t> (zeros) + literals;
+
+        if ((count == 0) || (count > (words - i)) || (static_cast<size_t> (pEnd - pIn) < (static_cast<size_t> (literals) << 3)))
+            return false;
+
+        if (!delta)
+            memset(pOut + (i << 3), 0, static_cast<size_t> (zeros) << 3);
+
+        i += zeros;
+
+        for (u32 j = 0; j < literals; j++, i++, pIn += 8)
+        {
+            u64 word;
+            memcpy(&word, pIn, 8);
+            if (delta)
+            {
+                u64 base;
+                memcpy(&base, pOut + (i << 3), 8);
+                word ^= base;
+            }
+            memcpy(pOut + (i << 3), &word, 8);
+        }
+    }
+
+    if (static_cast<size_t> (pEnd - pIn) != tail)
+        return false;
+
+    for (size_t j = words << 3; j < m_iStateSize; j++)
+        pOut[j] = delta ? (pOut[j] ^ *pIn++) : *pIn++;
+
+    return true;
+}
@@ -0,0 +1,108 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef REWINDBUFFER_H
+#define	REWINDBUFFER_H
+
+#include "definitions.h"
+#define MINIZ_HEADER_FILE_ONLY
+#include "miniz/miniz.c"
+
+const int kRewindDefaultBufferSize = 16 * 1024 * 1024;
+const int kRewindDefaultMaxSnapshots = 3600;
+const int kRewindDefaultFrameInterval = 1;
+const int kRewindDefaultKeyframeInterval = 60;
+
+class GearboyCore;
+
+struct RewindEntry
+{
+    size_t offset;
+    size_t size;
+    bool keyframe;
+    bool compressed;
+};
+
+class RewindBuffer
+{
+public:
+    RewindBuffer(GearboyCore* pCore);
+    ~RewindBuffer();
+    void Reset();
+    void Enable(bool enabled);
+    bool IsEnabled() const;
+    void SetParameters(int bufferSize, int maxSnapshots, int frameInterval, int keyframeInterval);
+    void Frame();
+    bool StepBack(int snapshots);
+    int GetSnapshotCount() const;
+
+private:
+    void Allocate();
+    void Release();
+    bool AllocateStateBuffers(size_t stateSize);
+    void PushSnapshot();
+    void StoreEntry(size_t size, bool keyframe);
+    bool ExtractEntry(int entry, u8* pOut);
+    size_t EncodeRuns(const u8* pData, const u8* pBase);
+    bool DecodeRuns(const u8* pIn, size_t size, u8* pOut, bool delta);
+    RewindEntry* GetEntry(int entry);
+
+private:
+    GearboyCore* m_pCore;
+    tdefl_compressor* m_pCompressor;
+    mz_uint m_iCompressionFlags;
+    u8* m_pBuffer;
+    RewindEntry* m_pEntries;
+    u8* m_pCurrent;
+    u8* m_pNext;
+    u8* m_pWork;
+    u8* m_pEncoded;
+    u8* m_pCompressed;
+    bool m_bEnabled;
+    bool m_bCurrentValid;
+    bool m_bSkipFrame;
+    size_t m_iStateSize;
+    size_t m_iEncodedSize;
+    size_t m_iBufferSize;
+    size_t m_iWritePosition;
+    int m_iMaxSnapshots;
+    int m_iFrameInterval;
+    int m_iKeyframeInterval;
+    int m_iFirstEntry;
+    int m_iEntryCount;
+    int m_iFrameCounter;
+    int m_iSnapshotCounter;
+};
+
+inline bool RewindBuffer::IsEnabled() const
+{
+    return m_bEnabled;
+}
+
+inline int RewindBuffer::GetSnapshotCount() const
+{
+    return m_iEntryCount;
+}
+
+inline RewindEntry* RewindBuffer::GetEntry(int entry)
+{
+    return &m_pEntries[(m_iFirstEntry + entry) % m_iMaxSnapshots];
+}
+
+#endif	/* REWINDBUFFER_H */
@@ -64,6 +64,7 @@ void RomOnlyMemoryRule::PerformWrite(u16 address, u8 value)
         if (m_pCartridge->GetRAMSize() > 0)
         {
             m_pMemory->Load(address, value);
+            MarkRamDirty(address - 0xA000);
         }
         else
         {
@@ -79,7 +80,7 @@ void RomOnlyMemoryRule::Reset(bool bCGB)
     m_bCGB = bCGB;
 }
 
-void RomOnlyMemoryRule::SaveRam(std::ofstream &file)
+void RomOnlyMemoryRule::SaveRam(std::ostream &file)
 {
     Log("RomOnlyMemoryRule save RAM...");
 
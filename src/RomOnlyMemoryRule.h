@@ -31,7 +31,7 @@ public:
     virtual u8 PerformRead(u16 address);
     virtual void PerformWrite(u16 address, u8 value);
     virtual void Reset(bool bCGB);
-    virtual void SaveRam(std::ofstream &file);
+    virtual void SaveRam(std::ostream &file);
     virtual bool LoadRam(std::ifstream &file, s32 fileSize);
 };
 
@@ -0,0 +1,161 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include "SDLAudioSink.h"
+
+SDLAudioSink::SDLAudioSink()
+{
+    InitPointer(m_pRing);
+    m_iRingMask = 0;
+    m_iTargetFill = 0;
+    SDL_AtomicSet(&m_WritePos, 0);
+    SDL_AtomicSet(&m_ReadPos, 0);
+    m_Device = 0;
+    m_bStarted = false;
+}
+
+SDLAudioSink::~SDLAudioSink()
+{
+    Stop();
+}
+
+// every instance that outputs sound opens its own device, so several
+// cores in the same process do not share one callback
+bool SDLAudioSink::Start(int sampleRate, int channels)
+{
+    if (m_bStarted)
+        return true;
+
+    int error = SDL_InitSubSystem(SDL_INIT_AUDIO);
+
+    if (error < 0)
+    {
+        Log("--> ** (%d) SDL Audio not initialized: %s", error, SDL_GetError());
+        return false;
+    }
+
+    m_iTargetFill = (sampleRate * channels * kSDLAudioLatencyMs) / 1000;
+
+    // room for twice the target plus a device period, rounded up to
+    // a power of two so the positions wrap with a mask
+    int size = 1;
+    while (size < ((m_iTargetFill * 2) + (kSDLAudioDeviceFrames * channels)))
+        size <<= 1;
+
+    m_pRing = new s16[size];
+    m_iRingMask = size - 1;
+    SDL_AtomicSet(&m_WritePos, 0);
+    SDL_AtomicSet(&m_ReadPos, 0);
+
+    SDL_AudioSpec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.freq = sampleRate;
+    spec.format = AUDIO_S16SYS;
+    spec.channels = channels;
+    spec.samples = kSDLAudioDeviceFrames;
+    spec.callback = FillBufferCallback;
+    spec.userdata = this;
+
+    m_Device = SDL_OpenAudioDevice(NULL, 0, &spec, NULL, 0);
+
+    if (m_Device == 0)
+    {
+        Log("--> ** SDL Audio not started: %s", SDL_GetError());
+        SafeDeleteArray(m_pRing);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return false;
+    }
+
+    SDL_PauseAudioDevice(m_Device, 0);
+
+    m_bStarted = true;
+    return true;
+}
+
+void SDLAudioSink::Stop()
+{
+    if (!m_bStarted)
+        return;
+
+    SDL_PauseAudioDevice(m_Device, 1);
+    SDL_CloseAudioDevice(m_Device);
+    m_Device = 0;
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    SafeDeleteArray(m_pRing);
+    m_bStarted = false;
+}
+
+void SDLAudioSink::Write(const s16* pSamples, int count)
+{
+    u32 writePos = SDL_AtomicGet(&m_WritePos);
+    int free = (m_iRingMask + 1) - static_cast<int> (writePos - SDL_AtomicGet(&m_ReadPos));
+
+    // the rate control keeps the ring around its target,
+    // whatever does not fit is dropped instead of blocking
+    if (count > free)
+        count = free;
+
+    for (int i = 0; i < count; i++)
+        m_pRing[(writePos + i) & m_iRingMask] = pSamples[i];
+
+    SDL_AtomicSet(&m_WritePos, writePos + count);
+}
+
+void SDLAudioSink::Flush()
+{
+    if (!m_bStarted)
+        return;
+
+    SDL_LockAudioDevice(m_Device);
+    SDL_AtomicSet(&m_ReadPos, SDL_AtomicGet(&m_WritePos));
+    SDL_UnlockAudioDevice(m_Device);
+}
+
+float SDLAudioSink::GetFillRatio()
+{
+    if (!m_bStarted)
+        return -1.0f;
+
+    u32 fill = SDL_AtomicGet(&m_WritePos) - SDL_AtomicGet(&m_ReadPos);
+
+    return static_cast<float> (fill) / m_iTargetFill;
+}
+
+void SDLAudioSink::FillBuffer(u8* pStream, int length)
+{
+    s16* pOut = reinterpret_cast<s16*> (pStream);
+    int count = length / static_cast<int> (sizeof(s16));
+    u32 readPos = SDL_AtomicGet(&m_ReadPos);
+    int available = static_cast<int> (SDL_AtomicGet(&m_WritePos) - readPos);
+    int n = (available < count) ? available : count;
+
+    for (int i = 0; i < n; i++)
+        pOut[i] = m_pRing[(readPos + i) & m_iRingMask];
+
+    // underrun, play silence for the rest of the period
+    if (n < count)
+        memset(pOut + n, 0, (count - n) * sizeof(s16));
+
+    SDL_AtomicSet(&m_ReadPos, readPos + n);
+}
+
+void SDLAudioSink::FillBufferCallback(void* pUserData, u8* pStream, int length)
+{
+    static_cast<SDLAudioSink*> (pUserData)->FillBuffer(pStream, length);
+}
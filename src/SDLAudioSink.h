@@ -0,0 +1,60 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef SDLAUDIOSINK_H
+#define	SDLAUDIOSINK_H
+
+#include <SDL2/SDL.h>
+#include "AudioSink.h"
+
+// latency the ring buffer is kept at by the dynamic rate control
+const int kSDLAudioLatencyMs = 20;
+// sample frames requested from the device on each callback
+const int kSDLAudioDeviceFrames = 512;
+
+// non blocking SDL output, the emulation writes into a single producer,
+// single consumer ring that the SDL callback drains without locks
+class SDLAudioSink : public AudioSink
+{
+public:
+    SDLAudioSink();
+    ~SDLAudioSink();
+    bool Start(int sampleRate, int channels);
+    void Stop();
+    void Write(const s16* pSamples, int count);
+    void Flush();
+    float GetFillRatio();
+
+private:
+    void FillBuffer(u8* pStream, int length);
+    static void FillBufferCallback(void* pUserData, u8* pStream, int length);
+
+private:
+    s16* m_pRing;
+    int m_iRingMask;
+    int m_iTargetFill;
+    // free running sample counters, the producer only stores the write
+    // position and the consumer only stores the read position
+    SDL_atomic_t m_WritePos;
+    SDL_atomic_t m_ReadPos;
+    SDL_AudioDeviceID m_Device;
+    bool m_bStarted;
+};
+
+#endif	/* SDLAUDIOSINK_H */
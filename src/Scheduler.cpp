@@ -0,0 +1,96 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+
+#include "Scheduler.h"
+#include "Processor.h"
+#include "Video.h"
+#include "Audio.h"
+#include "Input.h"
+
+Scheduler::Scheduler(Processor* pProcessor, Video* pVideo, Audio* pAudio, Input* pInput)
+{
+    m_pProcessor = pProcessor;
+    m_pVideo = pVideo;
+    m_pAudio = pAudio;
+    m_pInput = pInput;
+    InitPointer(m_pFrameBuffer);
+    m_iPendingCycles = 0;
+    m_iNextEventCycles = 0;
+    m_iExtraCycles = 0;
+    m_bVBlank = false;
+}
+
+void Scheduler::Reset()
+{
+    m_iPendingCycles = 0;
+    m_iNextEventCycles = 0;
+    m_iExtraCycles = 0;
+    m_bVBlank = false;
+}
+
+void Scheduler::Synchronize()
+{
+    // Called before the CPU touches a register whose value depends on the
+    // cycles accumulated since the last event. The state may change after
+    // this, so the next event is recalculated after the current instruction.
+    RunComponents();
+    m_iNextEventCycles = 0;
+}
+
+void Scheduler::RunComponents()
+{
+    if (m_iPendingCycles == 0)
+        return;
+
+    unsigned int clockCycles = m_iPendingCycles;
+    m_iPendingCycles = 0;
+
+    m_pProcessor->UpdateTimers(clockCycles);
+    m_pProcessor->UpdateSerial(clockCycles);
+
+    unsigned int videoCycles = clockCycles;
+
+    if (m_pVideo->Tick(videoCycles, m_pFrameBuffer))
+        m_bVBlank = true;
+
+    m_iExtraCycles += videoCycles - clockCycles;
+
+    m_pAudio->Tick(videoCycles);
+    m_pInput->Tick(videoCycles);
+}
+
+void Scheduler::UpdateNextEvent()
+{
+    int next = m_pVideo->GetNextEventCycles();
+
+    int processor = m_pProcessor->GetNextEventCycles();
+    if (processor < next)
+        next = processor;
+
+    int audio = m_pAudio->GetNextEventCycles();
+    if (audio < next)
+        next = audio;
+
+    int input = m_pInput->GetNextEventCycles();
+    if (input < next)
+        next = input;
+
+    m_iNextEventCycles = (next > 0) ? next : 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+
+#ifndef SCHEDULER_H
+#define	SCHEDULER_H
+
+#include "definitions.h"
+
+class Processor;
+class Video;
+class Audio;
+class Input;
+
+class Scheduler
+{
+public:
+    Scheduler(Processor* pProcessor, Video* pVideo, Audio* pAudio, Input* pInput);
+    void Reset();
+    bool Tick(unsigned int &clockCycles, u8* pFrameBuffer);
+    void Synchronize();
+
+private:
+    void RunComponents();
+    void UpdateNextEvent();
+
+private:
+    Processor* m_pProcessor;
+    Video* m_pVideo;
+    Audio* m_pAudio;
+    Input* m_pInput;
+    u8* m_pFrameBuffer;
+    unsigned int m_iPendingCycles;
+    unsigned int m_iNextEventCycles;
+    unsigned int m_iExtraCycles;
+    bool m_bVBlank;
+};
+
+inline bool Scheduler::Tick(unsigned int &clockCycles, u8* pFrameBuffer)
+{
+    m_pFrameBuffer = pFrameBuffer;
+    m_iPendingCycles += clockCycles;
+
+    if (m_iPendingCycles < m_iNextEventCycles)
+        return false;
+
+    RunComponents();
+    UpdateNextEvent();
+
+    clockCycles += m_iExtraCycles;
+    m_iExtraCycles = 0;
+
+    bool vblank = m_bVBlank;
+    m_bVBlank = false;
+    return vblank;
+}
+
+#endif	/* SCHEDULER_H */
@@ -27,8 +27,9 @@ Video::Video(Memory* pMemory, Processor* pProcessor)
     m_pMemory->SetVideo(this);
     m_pProcessor = pProcessor;
     InitPointer(m_pFrameBuffer);
-    InitPointer(m_pColorFrameBuffer);
-    InitPointer(m_pSpriteXCacheBuffer);
+    InitPointer(m_pOutputFrameBuffer);
+    InitPointer(m_pPreviousFrameBuffer);
+    m_iLineSpriteCount = 0;
     InitPointer(m_pColorCacheBuffer);
     m_iStatusMode = 0;
     m_iStatusModeCounter = 0;
@@ -44,27 +45,51 @@ Video::Video(Memory* pMemory, Processor* pProcessor)
     m_bScanLineTransfered = false;
     m_iHideFrames = 0;
     m_IRQ48Signal = 0;
+    m_ColorCorrection = Color_Correction_None;
+    m_PixelFormat = Pixel_Format_RGBA8888;
+    m_iOutputPitch = GAMEBOY_WIDTH * 4;
+    m_bForceDirtyLines = true;
+
+    for (int i = 0; i < kDirtyLineWords; i++)
+    {
+        m_DirtyLines[i] = 0;
+        m_OutputLines[i] = 0;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        m_DMGPalette[i].red = m_DMGPalette[i].green = m_DMGPalette[i].blue = 0xFF - (i * 0x55);
+        m_DMGPalette[i].alpha = 0xFF;
+    }
+    UpdateDMGColors();
 }
 
 Video::~Video()
 {
-    SafeDeleteArray(m_pSpriteXCacheBuffer);
     SafeDeleteArray(m_pColorCacheBuffer);
     SafeDeleteArray(m_pFrameBuffer);
+    SafeDeleteArray(m_pPreviousFrameBuffer);
 }
 
 void Video::Init()
 {
     m_pFrameBuffer = new u8[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
-    m_pSpriteXCacheBuffer = new int[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
     m_pColorCacheBuffer = new u8[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
+    m_pPreviousFrameBuffer = new u32[GAMEBOY_WIDTH * GAMEBOY_HEIGHT];
     Reset(false);
 }
 
 void Video::Reset(bool bCGB)
 {
     for (int i = 0; i < (GAMEBOY_WIDTH * GAMEBOY_HEIGHT); i++)
-        m_pSpriteXCacheBuffer[i] = m_pFrameBuffer[i] = m_pColorCacheBuffer[i] = 0;
+        m_pFrameBuffer[i] = m_pColorCacheBuffer[i] = 0;
+
+    for (int x = 0; x < GAMEBOY_WIDTH; x++)
+        m_ScanLineBuffer[x] = m_SpriteXLineBuffer[x] = 0;
+
+    m_iLineSpriteCount = 0;
+
+    m_bForceDirtyLines = true;
 
     for (int p = 0; p < 8; p++)
         for (int c = 0; c < 4; c++)
@@ -72,6 +97,8 @@ void Video::Reset(bool bCGB)
                 m_CGBBackgroundPalettes[p][c].blue = m_CGBSpritePalettes[p][c].red =
                 m_CGBSpritePalettes[p][c].green = m_CGBSpritePalettes[p][c].blue = 0;
 
+    UpdateCGBColors();
+
     m_iStatusMode = 1;
     m_iStatusModeCounter = 0;
     m_iStatusModeCounterAux = 0;
@@ -88,9 +115,9 @@ void Video::Reset(bool bCGB)
     m_IRQ48Signal = 0;
 }
 
-bool Video::Tick(unsigned int &clockCycles, GB_Color* pColorFrameBuffer)
+bool Video::Tick(unsigned int &clockCycles, u8* pOutputFrameBuffer)
 {
-    m_pColorFrameBuffer = pColorFrameBuffer;
+    m_pOutputFrameBuffer = pOutputFrameBuffer;
 
     bool vblank = false;
     m_iStatusModeCounter += clockCycles;
@@ -218,6 +245,7 @@ bool Video::Tick(unsigned int &clockCycles, GB_Color* pColorFrameBuffer)
                 {
                     m_iStatusModeCounter -= 80;
                     m_iStatusMode = 3;
+                    EvaluateSprites(m_iStatusModeLYCounter);
                     m_bScanLineTransfered = false;
                     m_IRQ48Signal &= 0x08;
                     UpdateStatRegister();
@@ -232,7 +260,7 @@ bool Video::Tick(unsigned int &clockCycles, GB_Color* pColorFrameBuffer)
                     m_iTileCycleCounter += clockCycles;
                     u8 lcdc = m_pMemory->Retrieve(0xFF40);
 
-                    if (m_bScreenEnabled && IsSetBit(lcdc, 7))
+                    if (m_bScreenEnabled && IsSetBit(lcdc, 7) && IsValidPointer(m_pOutputFrameBuffer))
                     {
                         while (m_iTileCycleCounter >= 3)
                         {
@@ -319,6 +347,50 @@ bool Video::Tick(unsigned int &clockCycles, GB_Color* pColorFrameBuffer)
     return vblank;
 }
 
+int Video::GetNextEventCycles() const
+{
+    if (m_bScreenEnabled)
+    {
+        switch (m_iStatusMode)
+        {
+            case 0:
+                return 204 - m_iStatusModeCounter;
+            case 1:
+            {
+                int next = 456 - m_iStatusModeCounterAux;
+
+                if ((4560 - m_iStatusModeCounter) < next)
+                    next = 4560 - m_iStatusModeCounter;
+
+                if (m_iStatusModeLYCounter == 153)
+                {
+                    int reset_ly = 4104 - m_iStatusModeCounter;
+
+                    if ((4 - m_iStatusModeCounterAux) > reset_ly)
+                        reset_ly = 4 - m_iStatusModeCounterAux;
+
+                    if (reset_ly < next)
+                        next = reset_ly;
+                }
+
+                return next;
+            }
+            case 2:
+                return 80 - m_iStatusModeCounter;
+            default:
+                // Pixel transfer is rendered progressively, unless the
+                // frame is skipped and only the mode change matters
+                if (!IsValidPointer(m_pOutputFrameBuffer))
+                    return 172 - m_iStatusModeCounter;
+                return 0;
+        }
+    }
+    else if (m_iScreenEnableDelayCycles > 0)
+        return m_iScreenEnableDelayCycles;
+    else
+        return 70224 - m_iStatusModeCounter;
+}
+
 void Video::EnableScreen()
 {
     if (!m_bScreenEnabled)
@@ -351,6 +423,44 @@ const u8* Video::GetFrameBuffer() const
     return m_pFrameBuffer;
 }
 
+void Video::ClearDirtyLines()
+{
+    for (int i = 0; i < kDirtyLineWords; i++)
+    {
+        m_DirtyLines[i] = 0;
+        m_OutputLines[i] = 0;
+    }
+}
+
+const u32* Video::GetDirtyLines() const
+{
+    return m_DirtyLines;
+}
+
+bool Video::IsFrameDirty() const
+{
+    for (int i = 0; i < kDirtyLineWords; i++)
+    {
+        if (m_DirtyLines[i] != 0)
+            return true;
+    }
+
+    return false;
+}
+
+// true when every line was written to the output buffer since the
+// dirty lines were cleared, with the screen off nothing is written
+bool Video::IsFrameComplete() const
+{
+    for (int line = 0; line < GAMEBOY_HEIGHT; line++)
+    {
+        if ((m_OutputLines[line >> 5] & (1 << (line & 0x1F))) == 0)
+            return false;
+    }
+
+    return true;
+}
+
 void Video::UpdatePaletteToSpecification(bool background, u8 value)
 {
     bool hl = IsSetBit(value, 0);
@@ -433,6 +543,8 @@ void Video::SetColorPalette(bool background, u8 value)
                     (m_CGBSpritePalettes[pal][index].green & 0x18) | half_green_low;
         }
     }
+
+    UpdateCGBColor(background, pal, index);
 }
 
 int Video::GetCurrentStatusMode() const
@@ -440,6 +552,37 @@ int Video::GetCurrentStatusMode() const
     return m_iStatusMode;
 }
 
+void Video::SetColorCorrection(Gameboy_Color_Correction correction)
+{
+    m_ColorCorrection = correction;
+    UpdateCGBColors();
+}
+
+void Video::SetPixelFormat(Gameboy_Pixel_Format format, int pitch)
+{
+    int bytes_per_pixel = 4;
+
+    if (format == Pixel_Format_RGB565)
+        bytes_per_pixel = 2;
+    else if (format == Pixel_Format_Indexed)
+        bytes_per_pixel = 1;
+
+    m_PixelFormat = format;
+    m_iOutputPitch = (pitch > 0) ? pitch : (GAMEBOY_WIDTH * bytes_per_pixel);
+    m_bForceDirtyLines = true;
+
+    UpdateCGBColors();
+    UpdateDMGColors();
+}
+
+void Video::SetDMGPalette(const GB_Color* pPalette)
+{
+    for (int i = 0; i < 4; i++)
+        m_DMGPalette[i] = pPalette[i];
+
+    UpdateDMGColors();
+}
+
 void Video::ResetWindowLine()
 {
     u8 wy = m_pMemory->Retrieve(0xFF4A);
@@ -450,7 +593,7 @@ void Video::ResetWindowLine()
 
 void Video::ScanLine(int line)
 {
-    if (IsValidPointer(m_pColorFrameBuffer))
+    if (IsValidPointer(m_pOutputFrameBuffer))
     {
         u8 lcdc = m_pMemory->Retrieve(0xFF40);
 
@@ -469,8 +612,9 @@ void Video::ScanLine(int line)
                 black.green = 0;
                 black.blue = 0;
                 black.alpha = 0xFF;
+                u32 color = (m_PixelFormat == Pixel_Format_Indexed) ? kIndexedBlankColor : EncodeColor(black);
                 for (int x = 0; x < GAMEBOY_WIDTH; x++)
-                    m_pColorFrameBuffer[line_width + x] = black;
+                    m_ScanLineBuffer[x] = color;
             }
             else
             {
@@ -478,14 +622,61 @@ void Video::ScanLine(int line)
                     m_pFrameBuffer[line_width + x] = 0;
             }
         }
+
+        OutputScanLine(line);
+    }
+}
+
+void Video::OutputScanLine(int line)
+{
+    u8* pOutput = m_pOutputFrameBuffer + (line * m_iOutputPitch);
+
+    if (!m_bCGB)
+    {
+        const u8* pIndices = m_pFrameBuffer + (line * GAMEBOY_WIDTH);
+        for (int x = 0; x < GAMEBOY_WIDTH; x++)
+            m_ScanLineBuffer[x] = m_DMGColors[pIndices[x]];
+    }
+
+    u32* pPreviousLine = m_pPreviousFrameBuffer + (line * GAMEBOY_WIDTH);
+
+    if (m_bForceDirtyLines || (memcmp(pPreviousLine, m_ScanLineBuffer, sizeof(m_ScanLineBuffer)) != 0))
+    {
+        memcpy(pPreviousLine, m_ScanLineBuffer, sizeof(m_ScanLineBuffer));
+        m_DirtyLines[line >> 5] |= (1 << (line & 0x1F));
+    }
+
+    m_OutputLines[line >> 5] |= (1 << (line & 0x1F));
+
+    // everything is compared again once a whole frame went out
+    if (line == (GAMEBOY_HEIGHT - 1))
+        m_bForceDirtyLines = false;
+
+    switch (m_PixelFormat)
+    {
+        case Pixel_Format_RGB565:
+        {
+            u16* pOutput16 = reinterpret_cast<u16*> (pOutput);
+            for (int x = 0; x < GAMEBOY_WIDTH; x++)
+                pOutput16[x] = static_cast<u16> (m_ScanLineBuffer[x]);
+            break;
+        }
+        case Pixel_Format_Indexed:
+        {
+            for (int x = 0; x < GAMEBOY_WIDTH; x++)
+                pOutput[x] = static_cast<u8> (m_ScanLineBuffer[x]);
+            break;
+        }
+        default:
+        {
+            memcpy(pOutput, m_ScanLineBuffer, sizeof(m_ScanLineBuffer));
+            break;
+        }
     }
 }
 
 void Video::RenderBG(int line, int pixel, int count)
 {
-    int offset_x_init = pixel % 8;
-    int offset_x_end = offset_x_init + count;
-    int screen_tile = pixel / 8;
     u8 lcdc = m_pMemory->Retrieve(0xFF40);
     int line_width = (line * GAMEBOY_WIDTH);
 
@@ -495,18 +686,26 @@ void Video::RenderBG(int line, int pixel, int count)
         int map_start_addr = IsSetBit(lcdc, 3) ? 0x9C00 : 0x9800;
         u8 scroll_x = m_pMemory->Retrieve(0xFF43);
         u8 scroll_y = m_pMemory->Retrieve(0xFF42);
+        u8 palette = m_bCGB ? 0 : m_pMemory->Retrieve(0xFF47);
         u8 line_scrolled = line + scroll_y;
         int line_scrolled_32 = (line_scrolled / 8) * 32;
         int tile_pixel_y = line_scrolled % 8;
         int tile_pixel_y_2 = tile_pixel_y * 2;
         int tile_pixel_y_flip_2 = (7 - tile_pixel_y) * 2;
+        int screen_pixel_x = pixel;
+        int screen_pixel_end = pixel + count;
 
-        for (int offset_x = offset_x_init; offset_x < offset_x_end; offset_x++)
+        // fetch every tile row touched by this run only once
+        while (screen_pixel_x < screen_pixel_end)
         {
-            int screen_pixel_x = (screen_tile * 8) + offset_x;
             u8 map_pixel_x = screen_pixel_x + scroll_x;
             int map_tile_x = map_pixel_x / 8;
             int map_tile_offset_x = map_pixel_x % 8;
+            int tile_pixels = 8 - map_tile_offset_x;
+
+            if (tile_pixels > (screen_pixel_end - screen_pixel_x))
+                tile_pixels = screen_pixel_end - screen_pixel_x;
+
             u16 map_tile_addr = map_start_addr + line_scrolled_32 + map_tile_x;
             int map_tile = 0;
 
@@ -519,20 +718,20 @@ void Video::RenderBG(int line, int pixel, int count)
             {
                 map_tile = m_pMemory->Retrieve(map_tile_addr);
             }
-            
+
             u8 cgb_tile_attr = m_bCGB ? m_pMemory->ReadCGBLCDRAM(map_tile_addr, true) : 0;
-            u8 cgb_tile_pal = m_bCGB ? (cgb_tile_attr & 0x07) : 0;
-            bool cgb_tile_bank = m_bCGB ? IsSetBit(cgb_tile_attr, 3) : false;
-            bool cgb_tile_xflip = m_bCGB ? IsSetBit(cgb_tile_attr, 5) : false;
-            bool cgb_tile_yflip = m_bCGB ? IsSetBit(cgb_tile_attr, 6) : false;
-            bool cgb_tile_priority = m_bCGB ? IsSetBit(cgb_tile_attr, 7) : false;
+            u8 cgb_tile_pal = cgb_tile_attr & 0x07;
+            bool cgb_tile_bank = IsSetBit(cgb_tile_attr, 3);
+            bool cgb_tile_xflip = IsSetBit(cgb_tile_attr, 5);
+            bool cgb_tile_yflip = IsSetBit(cgb_tile_attr, 6);
+            bool cgb_tile_priority = IsSetBit(cgb_tile_attr, 7);
             int map_tile_16 = map_tile * 16;
             u8 byte1 = 0;
             u8 byte2 = 0;
-            int final_pixely_2 = (m_bCGB && cgb_tile_yflip) ? tile_pixel_y_flip_2 : tile_pixel_y_2;
+            int final_pixely_2 = cgb_tile_yflip ? tile_pixel_y_flip_2 : tile_pixel_y_2;
             int tile_address = tile_start_addr + map_tile_16 + final_pixely_2;
 
-            if (m_bCGB && cgb_tile_bank)
+            if (cgb_tile_bank)
             {
                 byte1 = m_pMemory->ReadCGBLCDRAM(tile_address, true);
                 byte2 = m_pMemory->ReadCGBLCDRAM(tile_address + 1, true);
@@ -543,31 +742,24 @@ void Video::RenderBG(int line, int pixel, int count)
                 byte2 = m_pMemory->Retrieve(tile_address + 1);
             }
 
-            int pixel_x_in_tile = map_tile_offset_x;
-
-            if (m_bCGB && cgb_tile_xflip)
-            {
-                pixel_x_in_tile = 7 - pixel_x_in_tile;
-            }
-            int pixel_x_in_tile_bit = 0x1 << (7 - pixel_x_in_tile);
-            int pixel_data = (byte1 & pixel_x_in_tile_bit) ? 1 : 0;
-            pixel_data |= (byte2 & pixel_x_in_tile_bit) ? 2 : 0;
-
+            u16 tile_row = DecodeTileRow(byte1, byte2);
             int index = line_width + screen_pixel_x;
-            m_pColorCacheBuffer[index] = pixel_data & 0x03;
 
-            if (m_bCGB)
-            {
-                if (cgb_tile_priority && (pixel_data != 0))
-                    m_pColorCacheBuffer[index] = SetBit(m_pColorCacheBuffer[index], 2);
-                GB_Color color = m_CGBBackgroundPalettes[cgb_tile_pal][pixel_data];
-                m_pColorFrameBuffer[index] = ConvertTo8BitColor(color);
-            }
-            else
+            for (int offset_x = map_tile_offset_x; offset_x < (map_tile_offset_x + tile_pixels); offset_x++, index++, screen_pixel_x++)
             {
-                u8 palette = m_pMemory->Retrieve(0xFF47);
-                u8 color = (palette >> (pixel_data * 2)) & 0x03;
-                m_pFrameBuffer[index] = color;
+                int shift = cgb_tile_xflip ? (offset_x * 2) : (14 - (offset_x * 2));
+                int pixel_data = (tile_row >> shift) & 0x03;
+
+                if (m_bCGB)
+                {
+                    m_pColorCacheBuffer[index] = (cgb_tile_priority && (pixel_data != 0)) ? SetBit(pixel_data, 2) : pixel_data;
+                    m_ScanLineBuffer[screen_pixel_x] = m_CGBBackgroundColors[cgb_tile_pal][pixel_data];
+                }
+                else
+                {
+                    m_pColorCacheBuffer[index] = pixel_data;
+                    m_pFrameBuffer[index] = (palette >> (pixel_data * 2)) & 0x03;
+                }
             }
         }
     }
@@ -601,6 +793,7 @@ void Video::RenderWindow(int line)
 
     int tiles = IsSetBit(lcdc, 4) ? 0x8000 : 0x8800;
     int map = IsSetBit(lcdc, 6) ? 0x9C00 : 0x9800;
+    u8 palette = m_bCGB ? 0 : m_pMemory->Retrieve(0xFF47);
     int lineAdjusted = m_iWindowLine;
     int y_32 = (lineAdjusted / 8) * 32;
     int pixely = lineAdjusted % 8;
@@ -610,6 +803,12 @@ void Video::RenderWindow(int line)
 
     for (int x = 0; x < 32; x++)
     {
+        int mapOffsetX = (x * 8) + wx;
+
+        // the remaining tiles are off screen
+        if (mapOffsetX >= GAMEBOY_WIDTH)
+            break;
+
         int tile = 0;
 
         if (tiles == 0x8800)
@@ -623,19 +822,18 @@ void Video::RenderWindow(int line)
         }
 
         u8 cgb_tile_attr = m_bCGB ? m_pMemory->ReadCGBLCDRAM(map + y_32 + x, true) : 0;
-        u8 cgb_tile_pal = m_bCGB ? (cgb_tile_attr & 0x07) : 0;
-        bool cgb_tile_bank = m_bCGB ? IsSetBit(cgb_tile_attr, 3) : false;
-        bool cgb_tile_xflip = m_bCGB ? IsSetBit(cgb_tile_attr, 5) : false;
-        bool cgb_tile_yflip = m_bCGB ? IsSetBit(cgb_tile_attr, 6) : false;
-        bool cgb_tile_priority = m_bCGB ? IsSetBit(cgb_tile_attr, 7) : false;
-        int mapOffsetX = x * 8;
+        u8 cgb_tile_pal = cgb_tile_attr & 0x07;
+        bool cgb_tile_bank = IsSetBit(cgb_tile_attr, 3);
+        bool cgb_tile_xflip = IsSetBit(cgb_tile_attr, 5);
+        bool cgb_tile_yflip = IsSetBit(cgb_tile_attr, 6);
+        bool cgb_tile_priority = IsSetBit(cgb_tile_attr, 7);
         int tile_16 = tile * 16;
         u8 byte1 = 0;
         u8 byte2 = 0;
-        int final_pixely_2 = (m_bCGB && cgb_tile_yflip) ? pixely_2_flip : pixely_2;
+        int final_pixely_2 = cgb_tile_yflip ? pixely_2_flip : pixely_2;
         int tile_address = tiles + tile_16 + final_pixely_2;
 
-        if (m_bCGB && cgb_tile_bank)
+        if (cgb_tile_bank)
         {
             byte1 = m_pMemory->ReadCGBLCDRAM(tile_address, true);
             byte2 = m_pMemory->ReadCGBLCDRAM(tile_address + 1, true);
@@ -646,44 +844,52 @@ void Video::RenderWindow(int line)
             byte2 = m_pMemory->Retrieve(tile_address + 1);
         }
 
-        for (int pixelx = 0; pixelx < 8; pixelx++)
-        {
-            int bufferX = (mapOffsetX + pixelx + wx);
-
-            if (bufferX < 0 || bufferX >= GAMEBOY_WIDTH)
-                continue;
-
-            int pixelx_pos = pixelx;
-
-            if (m_bCGB && cgb_tile_xflip)
-            {
-                pixelx_pos = 7 - pixelx_pos;
-            }
-
-            int pixel = (byte1 & (0x1 << (7 - pixelx_pos))) ? 1 : 0;
-            pixel |= (byte2 & (0x1 << (7 - pixelx_pos))) ? 2 : 0;
+        u16 tile_row = DecodeTileRow(byte1, byte2);
+        int pixelx_start = (mapOffsetX < 0) ? -mapOffsetX : 0;
+        int pixelx_end = ((mapOffsetX + 8) > GAMEBOY_WIDTH) ? (GAMEBOY_WIDTH - mapOffsetX) : 8;
 
-            int position = line_width + bufferX;
-            m_pColorCacheBuffer[position] = pixel & 0x03;
+        for (int pixelx = pixelx_start; pixelx < pixelx_end; pixelx++)
+        {
+            int shift = cgb_tile_xflip ? (pixelx * 2) : (14 - (pixelx * 2));
+            int pixel = (tile_row >> shift) & 0x03;
+            int position = line_width + mapOffsetX + pixelx;
 
             if (m_bCGB)
             {
-                if (cgb_tile_priority && (pixel != 0))
-                    m_pColorCacheBuffer[position] = SetBit(m_pColorCacheBuffer[position], 2);
-                GB_Color color = m_CGBBackgroundPalettes[cgb_tile_pal][pixel];
-                m_pColorFrameBuffer[position] = ConvertTo8BitColor(color);
+                m_pColorCacheBuffer[position] = (cgb_tile_priority && (pixel != 0)) ? SetBit(pixel, 2) : pixel;
+                m_ScanLineBuffer[mapOffsetX + pixelx] = m_CGBBackgroundColors[cgb_tile_pal][pixel];
             }
             else
             {
-                u8 palette = m_pMemory->Retrieve(0xFF47);
-                u8 color = (palette >> (pixel * 2)) & 0x03;
-                m_pFrameBuffer[position] = color;
+                m_pColorCacheBuffer[position] = pixel;
+                m_pFrameBuffer[position] = (palette >> (pixel * 2)) & 0x03;
             }
         }
     }
     m_iWindowLine++;
 }
 
+void Video::EvaluateSprites(int line)
+{
+    u8 lcdc = m_pMemory->Retrieve(0xFF40);
+    int sprite_height = IsSetBit(lcdc, 2) ? 16 : 8;
+
+    m_iLineSpriteCount = 0;
+
+    // the first entries in OAM order win, even if they are off screen horizontally
+    for (int sprite = 0; (sprite < 40) && (m_iLineSpriteCount < kMaxSpritesPerLine); sprite++)
+    {
+        int sprite_y = m_pMemory->Retrieve(0xFE00 + (sprite * 4)) - 16;
+
+        if ((sprite_y > line) || ((sprite_y + sprite_height) <= line))
+            continue;
+
+        m_LineSprites[m_iLineSpriteCount] = sprite;
+        m_LineSpritesY[m_iLineSpriteCount] = sprite_y;
+        m_iLineSpriteCount++;
+    }
+}
+
 void Video::RenderSprites(int line)
 {
     u8 lcdc = m_pMemory->Retrieve(0xFF40);
@@ -694,12 +900,14 @@ void Video::RenderSprites(int line)
     int sprite_height = IsSetBit(lcdc, 2) ? 16 : 8;
     int line_width = (line * GAMEBOY_WIDTH);
 
-    for (int sprite = 39; sprite >= 0; sprite--)
+    // lower OAM entries are drawn last so they end up on top
+    for (int i = m_iLineSpriteCount - 1; i >= 0; i--)
     {
-        int sprite_4 = sprite * 4;
-        int sprite_y = m_pMemory->Retrieve(0xFE00 + sprite_4) - 16;
+        int sprite_4 = m_LineSprites[i] * 4;
+        int sprite_y = m_LineSpritesY[i];
 
-        if ((sprite_y > line) || ((sprite_y + sprite_height) <= line))
+        // the sprite size may have changed since OAM search
+        if ((sprite_y + sprite_height) <= line)
             continue;
 
         int sprite_x = m_pMemory->Retrieve(0xFE00 + sprite_4 + 1) - 8;
@@ -744,10 +952,11 @@ void Video::RenderSprites(int line)
             byte2 = m_pMemory->Retrieve(tile_address + 1);
         }
 
+        u16 tile_row = DecodeTileRow(byte1, byte2);
+
         for (int pixelx = 0; pixelx < 8; pixelx++)
         {
-            int pixel = (byte1 & (0x01 << (xflip ? pixelx : 7 - pixelx))) ? 1 : 0;
-            pixel |= (byte2 & (0x01 << (xflip ? pixelx : 7 - pixelx))) ? 2 : 0;
+            int pixel = (tile_row >> (xflip ? (pixelx * 2) : (14 - (pixelx * 2)))) & 0x03;
 
             if (pixel == 0)
                 continue;
@@ -767,7 +976,7 @@ void Video::RenderSprites(int line)
             }
             else
             {
-                int sprite_x_cache = m_pSpriteXCacheBuffer[position];
+                int sprite_x_cache = m_SpriteXLineBuffer[bufferX];
                 if (IsSetBit(color_cache, 3) && (sprite_x_cache < sprite_x))
                     continue;
             }
@@ -776,11 +985,10 @@ void Video::RenderSprites(int line)
                 continue;
 
             m_pColorCacheBuffer[position] = SetBit(color_cache, 3);
-            m_pSpriteXCacheBuffer[position] = sprite_x;
+            m_SpriteXLineBuffer[bufferX] = sprite_x;
             if (m_bCGB)
             {
-                GB_Color color = m_CGBSpritePalettes[cgb_tile_pal][pixel];
-                m_pColorFrameBuffer[position] = ConvertTo8BitColor(color);
+                m_ScanLineBuffer[bufferX] = m_CGBSpriteColors[cgb_tile_pal][pixel];
             }
             else
             {
@@ -838,12 +1046,159 @@ void Video::SetIRQ48Signal(u8 signal)
     m_IRQ48Signal = signal;
 }
 
+void Video::SaveState(std::ostream& stream)
+{
+    stream.write(reinterpret_cast<const char*> (&m_iStatusMode), sizeof(m_iStatusMode));
+    stream.write(reinterpret_cast<const char*> (&m_iStatusModeCounter), sizeof(m_iStatusModeCounter));
+    stream.write(reinterpret_cast<const char*> (&m_iStatusModeCounterAux), sizeof(m_iStatusModeCounterAux));
+    stream.write(reinterpret_cast<const char*> (&m_iStatusModeLYCounter), sizeof(m_iStatusModeLYCounter));
+    stream.write(reinterpret_cast<const char*> (&m_iScreenEnableDelayCycles), sizeof(m_iScreenEnableDelayCycles));
+    stream.write(reinterpret_cast<const char*> (&m_iStatusVBlankLine), sizeof(m_iStatusVBlankLine));
+    stream.write(reinterpret_cast<const char*> (&m_iPixelCounter), sizeof(m_iPixelCounter));
+    stream.write(reinterpret_cast<const char*> (&m_iTileCycleCounter), sizeof(m_iTileCycleCounter));
+    stream.write(reinterpret_cast<const char*> (&m_bScreenEnabled), sizeof(m_bScreenEnabled));
+    stream.write(reinterpret_cast<const char*> (m_CGBSpritePalettes), sizeof(m_CGBSpritePalettes));
+    stream.write(reinterpret_cast<const char*> (m_CGBBackgroundPalettes), sizeof(m_CGBBackgroundPalettes));
+    stream.write(reinterpret_cast<const char*> (&m_bScanLineTransfered), sizeof(m_bScanLineTransfered));
+    stream.write(reinterpret_cast<const char*> (&m_iWindowLine), sizeof(m_iWindowLine));
+    stream.write(reinterpret_cast<const char*> (&m_iHideFrames), sizeof(m_iHideFrames));
+    stream.write(reinterpret_cast<const char*> (&m_IRQ48Signal), sizeof(m_IRQ48Signal));
+    stream.write(reinterpret_cast<const char*> (m_pFrameBuffer), GAMEBOY_WIDTH * GAMEBOY_HEIGHT);
+
+    // the caches are only valid for the line being rendered
+    int line_width = (m_iStatusModeLYCounter < GAMEBOY_HEIGHT ? m_iStatusModeLYCounter : 0) * GAMEBOY_WIDTH;
+    stream.write(reinterpret_cast<const char*> (m_pColorCacheBuffer + line_width), GAMEBOY_WIDTH);
+    stream.write(reinterpret_cast<const char*> (m_SpriteXLineBuffer), sizeof(m_SpriteXLineBuffer));
+}
+
+void Video::LoadState(std::istream& stream)
+{
+    stream.read(reinterpret_cast<char*> (&m_iStatusMode), sizeof(m_iStatusMode));
+    stream.read(reinterpret_cast<char*> (&m_iStatusModeCounter), sizeof(m_iStatusModeCounter));
+    stream.read(reinterpret_cast<char*> (&m_iStatusModeCounterAux), sizeof(m_iStatusModeCounterAux));
+    stream.read(reinterpret_cast<char*> (&m_iStatusModeLYCounter), sizeof(m_iStatusModeLYCounter));
+    stream.read(reinterpret_cast<char*> (&m_iScreenEnableDelayCycles), sizeof(m_iScreenEnableDelayCycles));
+    stream.read(reinterpret_cast<char*> (&m_iStatusVBlankLine), sizeof(m_iStatusVBlankLine));
+    stream.read(reinterpret_cast<char*> (&m_iPixelCounter), sizeof(m_iPixelCounter));
+    stream.read(reinterpret_cast<char*> (&m_iTileCycleCounter), sizeof(m_iTileCycleCounter));
+    stream.read(reinterpret_cast<char*> (&m_bScreenEnabled), sizeof(m_bScreenEnabled));
+    stream.read(reinterpret_cast<char*> (m_CGBSpritePalettes), sizeof(m_CGBSpritePalettes));
+    stream.read(reinterpret_cast<char*> (m_CGBBackgroundPalettes), sizeof(m_CGBBackgroundPalettes));
+    UpdateCGBColors();
+    stream.read(reinterpret_cast<char*> (&m_bScanLineTransfered), sizeof(m_bScanLineTransfered));
+    stream.read(reinterpret_cast<char*> (&m_iWindowLine), sizeof(m_iWindowLine));
+    stream.read(reinterpret_cast<char*> (&m_iHideFrames), sizeof(m_iHideFrames));
+    stream.read(reinterpret_cast<char*> (&m_IRQ48Signal), sizeof(m_IRQ48Signal));
+    stream.read(reinterpret_cast<char*> (m_pFrameBuffer), GAMEBOY_WIDTH * GAMEBOY_HEIGHT);
+
+    int line_width = (m_iStatusModeLYCounter < GAMEBOY_HEIGHT ? m_iStatusModeLYCounter : 0) * GAMEBOY_WIDTH;
+    stream.read(reinterpret_cast<char*> (m_pColorCacheBuffer + line_width), GAMEBOY_WIDTH);
+    stream.read(reinterpret_cast<char*> (m_SpriteXLineBuffer), sizeof(m_SpriteXLineBuffer));
+
+    // the selected sprites are not saved, pick them again from the restored OAM
+    if (m_iStatusMode == 3)
+        EvaluateSprites(m_iStatusModeLYCounter);
+    else
+        m_iLineSpriteCount = 0;
+}
+
 GB_Color Video::ConvertTo8BitColor(GB_Color color)
 {
-    color.red = (color.red * 255) / 31;
-    color.green = (color.green * 255) / 31;
-    color.blue = (color.blue * 255) / 31;
+    switch (m_ColorCorrection)
+    {
+        case Color_Correction_Gamma:
+        {
+            color.red = kColorCorrectionGamma[color.red];
+            color.green = kColorCorrectionGamma[color.green];
+            color.blue = kColorCorrectionGamma[color.blue];
+            break;
+        }
+        case Color_Correction_LCD:
+        {
+            // channels bleed into each other and whites look dimmer on the CGB panel
+            int red = (color.red * 26) + (color.green * 4) + (color.blue * 2);
+            int green = (color.green * 24) + (color.blue * 8);
+            int blue = (color.red * 6) + (color.green * 4) + (color.blue * 22);
+            color.red = (red > 960 ? 960 : red) >> 2;
+            color.green = (green > 960 ? 960 : green) >> 2;
+            color.blue = (blue > 960 ? 960 : blue) >> 2;
+            break;
+        }
+        default:
+        {
+            color.red = (color.red * 255) / 31;
+            color.green = (color.green * 255) / 31;
+            color.blue = (color.blue * 255) / 31;
+            break;
+        }
+    }
+
     color.alpha = 0xFF;
 
     return color;
 }
+
+u32 Video::EncodeColor(GB_Color color) const
+{
+    u32 encoded = 0;
+
+    switch (m_PixelFormat)
+    {
+        case Pixel_Format_RGB565:
+        {
+            encoded = ((color.red & 0xF8) << 8) | ((color.green & 0xFC) << 3) | (color.blue >> 3);
+            break;
+        }
+        case Pixel_Format_BGRA8888:
+        {
+            u8 red = color.red;
+            color.red = color.blue;
+            color.blue = red;
+            memcpy(&encoded, &color, sizeof(encoded));
+            break;
+        }
+        default:
+        {
+            memcpy(&encoded, &color, sizeof(encoded));
+            break;
+        }
+    }
+
+    return encoded;
+}
+
+void Video::UpdateCGBColor(bool background, int pal, int index)
+{
+    if (m_PixelFormat == Pixel_Format_Indexed)
+    {
+        // bits 0-1: color, bits 2-4: palette, bit 5: sprite palette
+        u32 color = (pal << 2) | index;
+
+        if (background)
+            m_CGBBackgroundColors[pal][index] = color;
+        else
+            m_CGBSpriteColors[pal][index] = color | 0x20;
+    }
+    else if (background)
+        m_CGBBackgroundColors[pal][index] = EncodeColor(ConvertTo8BitColor(m_CGBBackgroundPalettes[pal][index]));
+    else
+        m_CGBSpriteColors[pal][index] = EncodeColor(ConvertTo8BitColor(m_CGBSpritePalettes[pal][index]));
+}
+
+void Video::UpdateCGBColors()
+{
+    for (int p = 0; p < 8; p++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            UpdateCGBColor(true, p, c);
+            UpdateCGBColor(false, p, c);
+        }
+    }
+}
+
+void Video::UpdateDMGColors()
+{
+    for (int i = 0; i < 4; i++)
+        m_DMGColors[i] = (m_PixelFormat == Pixel_Format_Indexed) ? i : EncodeColor(m_DMGPalette[i]);
+}
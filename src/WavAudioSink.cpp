@@ -0,0 +1,164 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#include "WavAudioSink.h"
+
+WavAudioSink::WavAudioSink(const char* szFilePath)
+{
+    strncpy(m_szFilePath, szFilePath, sizeof(m_szFilePath) - 1);
+    m_szFilePath[sizeof(m_szFilePath) - 1] = 0;
+    m_iSampleRate = 0;
+    m_iChannels = 0;
+    m_iDataSize = 0;
+    m_bCreated = false;
+
+    // unbuffered, so every write reports what actually reached the file
+    m_File.rdbuf()->pubsetbuf(NULL, 0);
+}
+
+WavAudioSink::~WavAudioSink()
+{
+    Stop();
+}
+
+bool WavAudioSink::Start(int sampleRate, int channels)
+{
+    using namespace std;
+
+    if (m_File.is_open())
+        return true;
+
+    if (m_bCreated)
+    {
+        // a WAV file has a single format, keep what was recorded so far
+        if ((sampleRate != m_iSampleRate) || (channels != m_iChannels))
+        {
+            Log("WAV recording format changed, not resuming: %s", m_szFilePath);
+            return false;
+        }
+
+        // resume the recording after the samples already written
+        m_File.open(m_szFilePath, ios::in | ios::out | ios::binary);
+
+        if (m_File.fail())
+        {
+            Log("Unable to reopen WAV file: %s", m_szFilePath);
+            m_File.clear();
+            return false;
+        }
+
+        m_File.seekp(kWavHeaderSize + m_iDataSize);
+        return true;
+    }
+
+    m_File.open(m_szFilePath, ios::out | ios::binary | ios::trunc);
+
+    if (m_File.fail())
+    {
+        Log("Unable to create WAV file: %s", m_szFilePath);
+        m_File.clear();
+        return false;
+    }
+
+    m_bCreated = true;
+    m_iSampleRate = sampleRate;
+    m_iChannels = channels;
+    m_iDataSize = 0;
+
+    // sizes are patched in when the file is closed
+    WriteHeader(m_iSampleRate, m_iChannels, 0);
+
+    return true;
+}
+
+void WavAudioSink::Stop()
+{
+    if (!m_File.is_open())
+        return;
+
+    m_File.seekp(0);
+    WriteHeader(m_iSampleRate, m_iChannels, m_iDataSize);
+    m_File.close();
+}
+
+void WavAudioSink::Write(const s16* pSamples, int count)
+{
+    u8 data[2 * 256];
+
+    while (count > 0)
+    {
+        int n = (count > 256) ? 256 : count;
+
+        // WAV data is little endian regardless of the host
+        for (int i = 0; i < n; i++)
+        {
+            data[i * 2] = pSamples[i] & 0xFF;
+            data[(i * 2) + 1] = (pSamples[i] >> 8) & 0xFF;
+        }
+
+        int size = n * 2;
+        std::streamsize written = m_File.rdbuf()->sputn(reinterpret_cast<const char*> (data), size);
+
+        if (written < size)
+        {
+            // only count the whole sample frames that were written and
+            // go back to their end so the next write stays aligned
+            u32 frame = m_iChannels * 2;
+            m_iDataSize += (static_cast<u32> (written) / frame) * frame;
+            m_File.seekp(kWavHeaderSize + m_iDataSize);
+            Log("Unable to write WAV data: %s", m_szFilePath);
+            return;
+        }
+
+        m_iDataSize += size;
+        pSamples += n;
+        count -= n;
+    }
+}
+
+// the recording is continuous, nothing is waiting to be played
+void WavAudioSink::Flush()
+{
+}
+
+static void WriteLittleEndian(u8* pBuffer, u32 value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        pBuffer[i] = (value >> (i * 8)) & 0xFF;
+}
+
+void WavAudioSink::WriteHeader(int sampleRate, int channels, u32 dataSize)
+{
+    u8 header[kWavHeaderSize];
+
+    memcpy(header, "RIFF", 4);
+    WriteLittleEndian(header + 4, 36 + dataSize, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    WriteLittleEndian(header + 16, 16, 4);
+    WriteLittleEndian(header + 20, 1, 2);
+    WriteLittleEndian(header + 22, channels, 2);
+    WriteLittleEndian(header + 24, sampleRate, 4);
+    WriteLittleEndian(header + 28, sampleRate * channels * 2, 4);
+    WriteLittleEndian(header + 32, channels * 2, 2);
+    WriteLittleEndian(header + 34, 16, 2);
+    memcpy(header + 36, "data", 4);
+    WriteLittleEndian(header + 40, dataSize, 4);
+
+    m_File.write(reinterpret_cast<const char*> (header), kWavHeaderSize);
+}
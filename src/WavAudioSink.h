@@ -0,0 +1,51 @@
+/*
+ * Gearboy - Nintendo Game Boy Emulator
+ * Copyright (C) 2012  Ignacio Sanchez
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses/ 
+ * 
+ */
+
+#ifndef WAVAUDIOSINK_H
+#define	WAVAUDIOSINK_H
+
+#include "AudioSink.h"
+
+// records the samples as a 16 bit PCM WAV file, it never blocks
+// the file is created on the first start, later starts append to it
+class WavAudioSink : public AudioSink
+{
+public:
+    WavAudioSink(const char* szFilePath);
+    ~WavAudioSink();
+    bool Start(int sampleRate, int channels);
+    void Stop();
+    void Write(const s16* pSamples, int count);
+    void Flush();
+
+private:
+    void WriteHeader(int sampleRate, int channels, u32 dataSize);
+
+private:
+    char m_szFilePath[512];
+    std::ofstream m_File;
+    int m_iSampleRate;
+    int m_iChannels;
+    u32 m_iDataSize;
+    bool m_bCreated;
+};
+
+const int kWavHeaderSize = 44;
+
+#endif	/* WAVAUDIOSINK_H */
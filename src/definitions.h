@@ -41,6 +41,12 @@
 #define SAVE_FILE_SIGNATURE "GearboySaveFile"
 #define SAVE_FILE_VERSION 5
 
+#define SAVESTATE_SIGNATURE "GearboySaveState"
+#define SAVESTATE_VERSION 1
+
+#define ROM_INDEX_SIGNATURE "GearboyROMIndex"
+#define ROM_INDEX_VERSION 1
+
 #define SafeDelete(pointer) if(pointer != NULL) {delete pointer; pointer = NULL;}
 #define SafeDeleteArray(pointer) if(pointer != NULL) {delete [] pointer; pointer = NULL;}
 
@@ -87,6 +93,21 @@ enum Gameboy_Keys
     Down_Key = 3
 };
 
+enum Gameboy_Pixel_Format
+{
+    Pixel_Format_RGBA8888 = 0,
+    Pixel_Format_BGRA8888 = 1,
+    Pixel_Format_RGB565 = 2,
+    Pixel_Format_Indexed = 3
+};
+
+enum Gameboy_Color_Correction
+{
+    Color_Correction_None = 0,
+    Color_Correction_Gamma = 1,
+    Color_Correction_LCD = 2
+};
+
 #ifdef DEBUG_GEARBOY
 #define Log(msg, ...) (Log_func(msg, ##__VA_ARGS__))
 #else
@@ -95,17 +116,14 @@ enum Gameboy_Keys
 
 inline void Log_func(const char* const msg, ...)
 {
-    static int count = 1;
     char szBuf[512];
 
     va_list args;
     va_start(args, msg);
-    vsprintf(szBuf, msg, args);
+    vsnprintf(szBuf, sizeof(szBuf), msg, args);
     va_end(args);
 
-    printf("%d: %s\n", count, szBuf);
-
-    count++;
+    printf("%s\n", szBuf);
 }
 
 inline u8 SetBit(const u8 value, const u8 bit)
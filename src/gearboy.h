@@ -25,7 +25,13 @@
 #include "Memory.h"
 #include "Processor.h"
 #include "Cartridge.h"
+#include "ROMScanner.h"
 #include "Audio.h" 
+#include "AudioSink.h"
+#include "WavAudioSink.h"
+#ifndef GEARBOY_NO_SDL
+#include "SDLAudioSink.h"
+#endif
 #include "Video.h" 
 #include "SixteenBitRegister.h" 
 #include "EightBitRegister.h" 